@@ -2,11 +2,54 @@
 #define __ALLOCATOR_TRAITS_H
 
 #include<memory>
+#include<type_traits>
+#include<algorithm>
+#include<cstring>
 
 namespace realloc4cpp {
 
 //////////////////////////////////////////////////////////////////////////////
-// Extended allocator_traits interface
+// Objects of type T can be moved to another place using memcpy() without
+// calling move-ctr and dtor. Specialize for own types to opt in.
+// Note: std::string of libstdc++ points to its own SSO-buffer so it cannot!
+template<class T>
+struct is_trivially_relocatable : std::is_trivially_copyable<T> {};
+
+template<class T>
+inline constexpr bool is_trivially_relocatable_v =
+    is_trivially_relocatable<T>::value;
+
+//////////////////////////////////////////////////////////////////////////////
+// The containers are constexpr since C++20 (allocation in constant
+// evaluation). The memory cannot outlive the evaluation: copy the result
+// to a std::array to keep a table built at compile time.
+#if __cpp_constexpr_dynamic_alloc >= 201907L
+#define REALLOC4CPP_CONSTEXPR20 constexpr
+#else
+#define REALLOC4CPP_CONSTEXPR20
+#endif
+
+constexpr bool is_constant_evaluated() noexcept
+{
+#if __cpp_lib_is_constant_evaluated >= 201811L
+    return std::is_constant_evaluated();
+#else
+    return false;
+#endif
+}
+//////////////////////////////////////////////////////////////////////////////
+// Alignment of the blocks of U for an allocator asking for alignment: it is
+// kept unless U needs more. The aligned allocators keep their Alignment
+// through rebind, so rebinding back gives the same type for any U.
+template<class U>
+constexpr std::size_t block_alignment(std::size_t alignment)
+{
+    return alignment > alignof(U) ? alignment : alignof(U);
+}
+//////////////////////////////////////////////////////////////////////////////
+// Extended allocator_traits interface. In constant evaluation the memory
+// comes from std::allocator and the blocks are never resized: the
+// allocator itself calls the C library.
 template<class Alloc>
 struct allocator_traits : public std::allocator_traits<Alloc>
 {
@@ -25,6 +68,30 @@ private:
         return a.allocate(n);
     }
 
+    template<class Alloc2>
+    static constexpr auto good_size_impl(const Alloc2 &a, size_type n, int)
+    -> decltype(a.good_size(n))
+    {
+        return a.good_size(n);
+    }
+    template<class Alloc2>
+    static constexpr size_type good_size_impl(const Alloc2 & , size_type n, ...)
+    {
+        return n;
+    }
+
+    template<class Alloc2>
+    static constexpr auto min_resizable_size_impl(const Alloc2 &a, int)
+    -> decltype(a.min_resizable_size())
+    {
+        return a.min_resizable_size();
+    }
+    template<class Alloc2>
+    static constexpr size_type min_resizable_size_impl(const Alloc2 & , ...)
+    {
+        return 0;
+    }
+
     template<class Alloc2>
     static constexpr auto expand_by_impl(Alloc2 &a, pointer p, size_type &size,
         size_type preferred_n, size_type least_n, int)
@@ -39,6 +106,33 @@ private:
         return false;
     }
 
+    template<class Alloc2>
+    static constexpr auto reallocate_impl(Alloc2 &a, pointer p,
+        size_type &size, size_type n, size_type used, int)
+    -> decltype(a.reallocate(p, size, n, used))
+    {
+        return a.reallocate(p, size, n, used);
+    }
+    template<class Alloc2>
+    static constexpr auto reallocate_impl(Alloc2 &a, pointer p,
+        size_type &size, size_type n, size_type , long)
+    -> decltype(a.reallocate(p, size, n))
+    {
+        return a.reallocate(p, size, n);
+    }
+    template<class Alloc2>
+    static pointer reallocate_impl(Alloc2 &a, pointer p,
+        size_type &size, size_type n, size_type used, ...)
+    {
+        pointer new_p = allocate_at_least_impl(a, n, 0);
+        std::memcpy(static_cast<void*>(std::addressof(*new_p)),
+            static_cast<const void*>(std::addressof(*p)),
+            std::min(used, n) * sizeof(typename Alloc::value_type));
+        a.deallocate(p, size);
+        size = n;
+        return new_p;
+    }
+
     template<class Alloc2>
     static constexpr auto shrink_by_impl(
         Alloc2 &a, pointer p, size_type &size, size_type n, int)
@@ -52,22 +146,61 @@ private:
     {
         return false;
     }
+    using constant_allocator = std::allocator<typename Alloc::value_type>;
 public:
+    [[nodiscard]] static constexpr pointer allocate(Alloc &a, size_type n)
+    {
+        if(is_constant_evaluated()) return constant_allocator().allocate(n);
+        return std::allocator_traits<Alloc>::allocate(a, n);
+    }
+    static constexpr void deallocate(Alloc &a, pointer p, size_type n)
+    {
+        if(is_constant_evaluated()) constant_allocator().deallocate(p, n);
+        else std::allocator_traits<Alloc>::deallocate(a, p, n);
+    }
     [[nodiscard]] static constexpr pointer allocate_at_least(
         Alloc &a, size_type &n)
     {
+        if(is_constant_evaluated()) return constant_allocator().allocate(n);
         return allocate_at_least_impl(a, n, 0);
     }
+    // The capacity the allocator really provides when n is requested
+    [[nodiscard]] static constexpr size_type good_size(
+        const Alloc &a, size_type n)
+    {
+        if(is_constant_evaluated()) return n;
+        return good_size_impl(a, n, 0);
+    }
+    // Capacity below which expand_by() never succeeds, 0 if there is none
+    [[nodiscard]] static constexpr size_type min_resizable_size(
+        const Alloc &a)
+    {
+        return min_resizable_size_impl(a, 0);
+    }
     [[nodiscard]] static constexpr bool expand_by(Alloc &a, pointer p,
         size_type &size, size_type preferred_n, size_type least_n)
     {
+        if(is_constant_evaluated()) return false;
         return expand_by_impl(a, p, size, preferred_n, least_n, 0);
     }
     [[nodiscard]] static constexpr bool shrink_by(Alloc &a, pointer p,
         size_type &size, size_type n)
     {
+        if(is_constant_evaluated()) return false;
         return shrink_by_impl(a, p, size, n, 0);
     }
+    // Like realloc(): moves the block to the new place if required.
+    // Only for trivially relocatable value_type. size is the current
+    // capacity on input and the new one on output. Only the first used
+    // elements are kept when the block is copied: the allocators copying
+    // by themselves get used as well, reallocate(p, size, n, used).
+    [[nodiscard]] static pointer reallocate(Alloc &a, pointer p,
+        size_type &size, size_type n, size_type used)
+    {
+        static_assert(
+            is_trivially_relocatable_v<typename Alloc::value_type>);
+        return reallocate_impl(a, p, size, n, used, 0);
+    }
 };
 //////////////////////////////////////////////////////////////////////////////
 
@@ -0,0 +1,682 @@
+#ifndef __AUTOGROW_ARRAY_H
+#define __AUTOGROW_ARRAY_H
+
+#include"raw_buffer.h"
+#include"growth_policy.h"
+#include"relocation_policy.h"
+#include<iterator>
+#include<type_traits>
+#include<algorithm>
+#include<stdexcept>
+#include<new>
+#include<cstring>
+#include<cassert>
+
+namespace realloc4cpp {
+
+//////////////////////////////////////////////////////////////////////////////
+// vector-like container
+template<class T, class Allocator = std::allocator<T>,
+    class Growth = doubling_growth, class Relocation = serial_relocation,
+    class Stats = default_realloc_stats>
+class autogrow_array : private Growth
+{
+public:
+    using value_type = T;
+    using allocator_type = Allocator;
+    using size_type = typename std::allocator_traits<Allocator>::size_type;
+    using difference_type = std::ptrdiff_t;
+    using reference = T &;
+    using const_reference = const T &;
+    using pointer = T *;
+    using const_pointer = const T *;
+    using iterator = T *;
+    using const_iterator = const T *;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+private:
+    raw_buffer<T, Allocator, Stats> buf;
+    T *next = buf.begin();
+
+    REALLOC4CPP_CONSTEXPR20 void grow_by(size_type );
+    REALLOC4CPP_CONSTEXPR20 void relocate(size_type );
+    REALLOC4CPP_CONSTEXPR20 void destroy_from(T * );
+    REALLOC4CPP_CONSTEXPR20 void auto_shrink();
+    template<class InputIt>
+    REALLOC4CPP_CONSTEXPR20 void append_impl(
+        InputIt , InputIt , std::input_iterator_tag);
+    template<class ForwardIt>
+    REALLOC4CPP_CONSTEXPR20 void append_impl(
+        ForwardIt , ForwardIt , std::forward_iterator_tag);
+    REALLOC4CPP_CONSTEXPR20 T &emplace_back_grow(T && );
+    // std::uninitialized_*() that are constexpr (they are since C++26)
+    template<class InputIt>
+    REALLOC4CPP_CONSTEXPR20 T *uninitialized_copy(InputIt , InputIt , T * );
+    REALLOC4CPP_CONSTEXPR20 T *uninitialized_fill_n(
+        T * , size_type , const T & );
+    REALLOC4CPP_CONSTEXPR20 T *uninitialized_value_construct_n(
+        T * , size_type );
+    // For trivially relocatable T: [p, p + n) become raw memory
+    T *open_gap(size_type , size_type );
+    void close_gap(size_type , size_type );
+    T *to_mutable(const_iterator it) { return buf.begin() + (it - begin()); }
+public:
+    constexpr autogrow_array() = default;
+    REALLOC4CPP_CONSTEXPR20 explicit autogrow_array(const Allocator &a)
+        : buf(a) {}
+    REALLOC4CPP_CONSTEXPR20 explicit autogrow_array(
+        size_type , const Allocator & = Allocator());
+    autogrow_array(const autogrow_array & ) = delete;
+    REALLOC4CPP_CONSTEXPR20 autogrow_array(autogrow_array &&o) noexcept
+    :
+        Growth(std::move(o)), buf(std::move(o.buf)), next(o.next)
+    {
+        o.next = o.buf.begin();
+    }
+    autogrow_array &operator=(const autogrow_array & ) = delete;
+    REALLOC4CPP_CONSTEXPR20 autogrow_array &operator=(
+        autogrow_array && ) noexcept(
+        std::allocator_traits<Allocator>::
+            propagate_on_container_move_assignment::value ||
+        std::allocator_traits<Allocator>::is_always_equal::value);
+    REALLOC4CPP_CONSTEXPR20 ~autogrow_array();
+
+    // In constant evaluation (C++20) all but insert(), erase(),
+    // shrink_to_fit() and trim() can be used
+    REALLOC4CPP_CONSTEXPR20 allocator_type get_allocator() const
+        { return buf.get_allocator(); }
+    REALLOC4CPP_CONSTEXPR20 Growth &growth_policy() { return *this; }
+
+    REALLOC4CPP_CONSTEXPR20 bool empty() const { return next == buf.begin(); }
+    REALLOC4CPP_CONSTEXPR20 size_type size() const
+        { return next - buf.begin(); }
+    REALLOC4CPP_CONSTEXPR20 size_type max_size() const
+        { return buf.max_capacity(); }
+    REALLOC4CPP_CONSTEXPR20 size_type capacity() const
+        { return buf.capacity(); }
+
+    REALLOC4CPP_CONSTEXPR20 T *data() { return buf.begin(); }
+    REALLOC4CPP_CONSTEXPR20 const T *data() const { return buf.begin(); }
+    REALLOC4CPP_CONSTEXPR20 T &operator[](size_type i)
+        { assert(i < size()); return buf.begin()[i]; }
+    REALLOC4CPP_CONSTEXPR20 const T &operator[](size_type i) const
+        { assert(i < size()); return buf.begin()[i]; }
+    REALLOC4CPP_CONSTEXPR20 T &at(size_type i)
+    {
+        if(i >= size()) throw std::out_of_range("autogrow_array::at()");
+        return buf.begin()[i];
+    }
+    REALLOC4CPP_CONSTEXPR20 const T &at(size_type i) const
+        { return const_cast<autogrow_array &>(*this).at(i); }
+    REALLOC4CPP_CONSTEXPR20 T &front()
+        { assert(!empty()); return *buf.begin(); }
+    REALLOC4CPP_CONSTEXPR20 const T &front() const
+        { assert(!empty()); return *buf.begin(); }
+    REALLOC4CPP_CONSTEXPR20 T &back() { assert(!empty()); return next[-1]; }
+    REALLOC4CPP_CONSTEXPR20 const T &back() const
+        { assert(!empty()); return next[-1]; }
+
+    REALLOC4CPP_CONSTEXPR20 iterator begin() { return buf.begin(); }
+    REALLOC4CPP_CONSTEXPR20 iterator end() { return next; }
+    REALLOC4CPP_CONSTEXPR20 const_iterator begin() const
+        { return buf.begin(); }
+    REALLOC4CPP_CONSTEXPR20 const_iterator end() const { return next; }
+    REALLOC4CPP_CONSTEXPR20 const_iterator cbegin() const { return begin(); }
+    REALLOC4CPP_CONSTEXPR20 const_iterator cend() const { return end(); }
+    REALLOC4CPP_CONSTEXPR20 reverse_iterator rbegin()
+        { return reverse_iterator(end()); }
+    REALLOC4CPP_CONSTEXPR20 reverse_iterator rend()
+        { return reverse_iterator(begin()); }
+    REALLOC4CPP_CONSTEXPR20 const_reverse_iterator rbegin() const
+        { return const_reverse_iterator(end()); }
+    REALLOC4CPP_CONSTEXPR20 const_reverse_iterator rend() const
+        { return const_reverse_iterator(begin()); }
+
+    REALLOC4CPP_CONSTEXPR20 void push_back(const T &v) { emplace_back(v); }
+    REALLOC4CPP_CONSTEXPR20 void push_back(T &&v)
+        { emplace_back(std::move(v)); }
+    template<class... Args>
+    REALLOC4CPP_CONSTEXPR20 T &emplace_back(Args &&... );
+    REALLOC4CPP_CONSTEXPR20 void pop_back();
+    REALLOC4CPP_CONSTEXPR20 void clear();
+    REALLOC4CPP_CONSTEXPR20 void reserve(size_type );
+    void shrink_to_fit();
+    // shrink_to_fit() that never relocates the elements, does nothing if
+    // the slack is less than min_slack_bytes. Returns the bytes released
+    std::size_t trim(std::size_t min_slack_bytes = 0);
+
+    // The tail is shifted inside the buffer, expanded in place if possible
+    template<class... Args> iterator emplace(const_iterator , Args &&... );
+    iterator insert(const_iterator pos, const T &v) { return emplace(pos, v); }
+    iterator insert(const_iterator pos, T &&v)
+        { return emplace(pos, std::move(v)); }
+    iterator insert(const_iterator , size_type , const T & );
+    template<class InputIt, class = typename
+        std::iterator_traits<InputIt>::iterator_category>
+    iterator insert(const_iterator , InputIt , InputIt );
+    iterator erase(const_iterator pos) { return erase(pos, pos + 1); }
+    iterator erase(const_iterator , const_iterator );
+
+    // Bulk operations: capacity is increased at most once per call
+    template<class InputIt>
+    REALLOC4CPP_CONSTEXPR20 void append(InputIt first, InputIt last)
+    {
+        append_impl(first, last,
+            typename std::iterator_traits<InputIt>::iterator_category());
+    }
+    REALLOC4CPP_CONSTEXPR20 void append_n(size_type , const T & );
+    REALLOC4CPP_CONSTEXPR20 void resize(size_type );
+    REALLOC4CPP_CONSTEXPR20 void resize(size_type , const T & );
+
+    REALLOC4CPP_CONSTEXPR20 void swap(autogrow_array &o) noexcept
+    {
+        using std::swap;
+        swap(growth_policy(), o.growth_policy());
+        buf.swap(o.buf);
+        swap(next, o.next);
+    }
+protected:
+    // Destroys the elements, frees the buffer and starts using a
+    REALLOC4CPP_CONSTEXPR20 void replace_allocator(const Allocator &a);
+    // Exchanges the elements, the allocators and the growth policies stay:
+    // for allocators that can free the buffers of each other only
+    void swap_buffers(autogrow_array &o) noexcept
+    {
+        buf.swap_blocks(o.buf);
+        std::swap(next, o.next);
+    }
+    // Takes the first n elements of the buffer for the constructed ones:
+    // for implicit-lifetime T whose bytes are already there (mapped file)
+    void adopt(size_type n)
+    {
+        static_assert(std::is_trivially_copyable<T>::value);
+        assert(empty() && n <= capacity());
+        next = buf.begin() + n;
+    }
+};
+//////////////////////////////////////////////////////////////////////////////
+//----------------------------------------------------------------------------
+template<class T, class A, class G, class R, class S>
+REALLOC4CPP_CONSTEXPR20
+autogrow_array<T,A,G,R,S>::autogrow_array(size_type initial_size, const A &a)
+:
+    buf(initial_size, a),
+    next(uninitialized_fill_n(buf.begin(), initial_size, T{}))
+{
+}
+//----------------------------------------------------------------------------
+template<class T, class A, class G, class R, class S>
+REALLOC4CPP_CONSTEXPR20
+autogrow_array<T,A,G,R,S>::~autogrow_array()
+{
+    destroy_from(buf.begin());
+}
+//----------------------------------------------------------------------------
+template<class T, class A, class G, class R, class S>
+REALLOC4CPP_CONSTEXPR20
+autogrow_array<T,A,G,R,S> &autogrow_array<T,A,G,R,S>::operator=(
+    autogrow_array &&o) noexcept(
+        std::allocator_traits<A>::
+            propagate_on_container_move_assignment::value ||
+        std::allocator_traits<A>::is_always_equal::value)
+{
+    using traits = std::allocator_traits<A>;
+    if(this == &o) return *this;
+    if constexpr(!traits::propagate_on_container_move_assignment::value &&
+        !traits::is_always_equal::value)
+    {
+        if(get_allocator() != o.get_allocator())
+        {
+            // The buffer cannot change the owner, move the elements
+            destroy_from(buf.begin());
+            append(std::make_move_iterator(o.begin()),
+                std::make_move_iterator(o.end()));
+            o.destroy_from(o.buf.begin());
+            return *this;
+        }
+    }
+    if constexpr(traits::propagate_on_container_move_assignment::value)
+        replace_allocator(o.get_allocator());
+    else
+        destroy_from(buf.begin());
+    static_cast<G &>(*this) = std::move(o);
+    buf.swap(o.buf);
+    std::swap(next, o.next);
+    return *this;
+}
+//----------------------------------------------------------------------------
+template<class T, class A, class G, class R, class S>
+REALLOC4CPP_CONSTEXPR20
+void autogrow_array<T,A,G,R,S>::replace_allocator(const A &a)
+{
+    destroy_from(buf.begin());
+    {
+        raw_buffer<T,A,S> old(std::move(buf)); // is freed here
+    }
+    buf.alloc() = a;
+    next = buf.begin();
+}
+//----------------------------------------------------------------------------
+template<class T, class A, class G, class R, class S>
+REALLOC4CPP_CONSTEXPR20
+void autogrow_array<T,A,G,R,S>::destroy_from(T *p)
+{
+    while(next != p) buf.destroy(--next);
+}
+//----------------------------------------------------------------------------
+// Gives the capacity back in place if the growth policy asks
+template<class T, class A, class G, class R, class S>
+REALLOC4CPP_CONSTEXPR20
+void autogrow_array<T,A,G,R,S>::auto_shrink()
+{
+    const size_type n = std::min(
+        growth_policy().shrink_decrement(capacity(), size()),
+        capacity() - size());
+    if(!n) return;
+    growth_policy().shrunk(buf.shrink_by(n));
+}
+//----------------------------------------------------------------------------
+template<class T, class A, class G, class R, class S>
+REALLOC4CPP_CONSTEXPR20
+void autogrow_array<T,A,G,R,S>::pop_back()
+{
+    assert(!empty());
+    buf.destroy(--next);
+    auto_shrink();
+}
+//----------------------------------------------------------------------------
+template<class T, class A, class G, class R, class S>
+REALLOC4CPP_CONSTEXPR20
+void autogrow_array<T,A,G,R,S>::clear()
+{
+    destroy_from(buf.begin());
+    auto_shrink();
+}
+//----------------------------------------------------------------------------
+template<class T, class A, class G, class R, class S>
+REALLOC4CPP_CONSTEXPR20
+void autogrow_array<T,A,G,R,S>::grow_by(size_type n)
+{
+    const size_type avail = buf.end() - next;
+    if(n <= avail) return;
+    const size_type least_n = n - avail;
+    const size_type cap_remain = buf.capacity_remain(least_n);
+    const auto increment = [=](size_type inc) {
+        return std::min(std::max(inc, least_n), cap_remain);
+    };
+    if(capacity() && buf.expand_by_at_least(
+        increment(growth_policy().expand_increment(capacity(), least_n)),
+        least_n))
+    {
+        // AWESOME!!! Buffer was enlarged!
+        // No need to move existing elements!
+        growth_policy().expanded(true);
+        return;
+    }
+    // cannot extend, move the buffer as usual
+    if(capacity()) growth_policy().expanded(false);
+    try
+    {
+        relocate(capacity() + increment(
+            growth_policy().relocate_increment(capacity(), least_n)));
+    }
+    catch(const std::bad_alloc &)
+    {
+        // No memory for the new buffer, the last chance is the minimal
+        // expansion in place (the neighbour could be freed meanwhile)
+        if(!buf.expand_by_at_least(least_n, least_n)) throw;
+    }
+}
+//----------------------------------------------------------------------------
+template<class T, class A, class G, class R, class S>
+REALLOC4CPP_CONSTEXPR20
+void autogrow_array<T,A,G,R,S>::relocate(size_type new_capacity)
+{
+    if(is_constant_evaluated()) // no memcpy(), threads or statistics
+    {
+        raw_buffer<T,A,S> new_buf(new_capacity, buf.get_allocator());
+        T *new_next = new_buf.begin();
+        for(T *p = buf.begin(); p != next; ++p)
+            new_buf.construct(new_next++, std::move(*p));
+        destroy_from(buf.begin());
+        buf.swap(new_buf);
+        next = new_next;
+        return;
+    }
+    const auto t0 = S::start();
+    const size_type bytes = size() * sizeof(T);
+    const T *old = buf.begin();
+    if constexpr(is_trivially_relocatable_v<T>)
+    {
+        // Just memcpy() or even remap the pages, no ctrs/dtors needed
+        const size_type n = size();
+        buf.reallocate(new_capacity, n);
+        next = buf.begin() + n;
+    }
+    else
+    {
+        raw_buffer<T,A,S> new_buf(new_capacity, buf.get_allocator());
+        T *new_next;
+        // Like std::move_if_noexcept(): the buffer is untouched on exception
+        if constexpr(std::is_nothrow_move_constructible<T>::value ||
+            !std::is_copy_constructible<T>::value)
+            new_next = R::uninitialized_move(new_buf.alloc(), buf.begin(),
+                next, new_buf.begin());
+        else
+            new_next = R::uninitialized_copy(new_buf.alloc(), buf.begin(),
+                next, new_buf.begin());
+        for(T *p = buf.begin(); p != next; ++p) buf.destroy(p);
+        buf.swap(new_buf); // the old buffer is freed with new_buf
+        next = new_next;
+    }
+    S::trace({trace_op::relocate, true, old, buf.begin(),
+        capacity() * sizeof(T), bytes});
+    // realloc() could resize the block in place, nothing was copied then
+    S::relocated(buf.begin() == old ? 0 : bytes, t0);
+}
+//----------------------------------------------------------------------------
+template<class T, class A, class G, class R, class S>
+template<class... Args>
+REALLOC4CPP_CONSTEXPR20
+T &autogrow_array<T,A,G,R,S>::emplace_back(Args &&... args)
+{
+    // args can refer to an element of the relocated buffer
+    if(next == buf.end())
+        return emplace_back_grow(T(std::forward<Args>(args)...));
+    buf.construct(next, std::forward<Args>(args)...);
+    return *next++;
+}
+//----------------------------------------------------------------------------
+template<class T, class A, class G, class R, class S>
+REALLOC4CPP_CONSTEXPR20
+T &autogrow_array<T,A,G,R,S>::emplace_back_grow(T &&v)
+{
+    grow_by(1); // increase capacity first
+    buf.construct(next, std::move(v));
+    return *next++;
+}
+//----------------------------------------------------------------------------
+template<class T, class A, class G, class R, class S>
+template<class InputIt>
+REALLOC4CPP_CONSTEXPR20
+T *autogrow_array<T,A,G,R,S>::uninitialized_copy(
+    InputIt first, InputIt last, T *dest)
+{
+    if(!is_constant_evaluated())
+        return std::uninitialized_copy(first, last, dest);
+    // Nothing to roll back: an exception ends the evaluation
+    for(; first != last; ++first) buf.construct(dest++, *first);
+    return dest;
+}
+//----------------------------------------------------------------------------
+template<class T, class A, class G, class R, class S>
+REALLOC4CPP_CONSTEXPR20
+T *autogrow_array<T,A,G,R,S>::uninitialized_fill_n(
+    T *dest, size_type n, const T &value)
+{
+    if(!is_constant_evaluated())
+        return std::uninitialized_fill_n(dest, n, value);
+    for(; n; n--) buf.construct(dest++, value);
+    return dest;
+}
+//----------------------------------------------------------------------------
+template<class T, class A, class G, class R, class S>
+REALLOC4CPP_CONSTEXPR20
+T *autogrow_array<T,A,G,R,S>::uninitialized_value_construct_n(
+    T *dest, size_type n)
+{
+    if(!is_constant_evaluated())
+        return std::uninitialized_value_construct_n(dest, n);
+    for(; n; n--) buf.construct(dest++);
+    return dest;
+}
+//----------------------------------------------------------------------------
+template<class T, class A, class G, class R, class S>
+T *autogrow_array<T,A,G,R,S>::open_gap(size_type i, size_type n)
+{
+    grow_by(n);
+    T *p = buf.begin() + i;
+    if(n) std::memmove(static_cast<void*>(p + n),
+        static_cast<const void*>(p), (next - p) * sizeof(T));
+    next += n;
+    return p;
+}
+//----------------------------------------------------------------------------
+template<class T, class A, class G, class R, class S>
+void autogrow_array<T,A,G,R,S>::close_gap(size_type i, size_type n)
+{
+    T *p = buf.begin() + i;
+    if(n) std::memmove(static_cast<void*>(p),
+        static_cast<const void*>(p + n), (next - p - n) * sizeof(T));
+    next -= n;
+}
+//----------------------------------------------------------------------------
+template<class T, class A, class G, class R, class S>
+template<class... Args>
+auto autogrow_array<T,A,G,R,S>::emplace(const_iterator pos, Args &&... args)
+    -> iterator
+{
+    const size_type i = pos - begin();
+    emplace_back(std::forward<Args>(args)...);
+    T *p = buf.begin() + i;
+    if constexpr(is_trivially_relocatable_v<T>)
+    {
+        // Rotate the bytes, no ctrs/dtors needed
+        alignas(T) unsigned char last[sizeof(T)];
+        std::memcpy(last, static_cast<const void*>(next - 1), sizeof(T));
+        std::memmove(static_cast<void*>(p + 1),
+            static_cast<const void*>(p), (next - 1 - p) * sizeof(T));
+        std::memcpy(static_cast<void*>(p), last, sizeof(T));
+    }
+    else
+        std::rotate(p, next - 1, next);
+    return p;
+}
+//----------------------------------------------------------------------------
+template<class T, class A, class G, class R, class S>
+auto autogrow_array<T,A,G,R,S>::insert(
+    const_iterator pos, size_type n, const T &value) -> iterator
+{
+    const size_type i = pos - begin();
+    if constexpr(is_trivially_relocatable_v<T>)
+    {
+        const T v(value); // value can refer to a shifted element
+        T *p = open_gap(i, n);
+        try
+        {
+            std::uninitialized_fill_n(p, n, v);
+        }
+        catch(...)
+        {
+            close_gap(i, n);
+            throw;
+        }
+        return p;
+    }
+    else
+    {
+        append_n(n, value);
+        std::rotate(buf.begin() + i, next - n, next);
+        return buf.begin() + i;
+    }
+}
+//----------------------------------------------------------------------------
+template<class T, class A, class G, class R, class S>
+template<class InputIt, class Category>
+auto autogrow_array<T,A,G,R,S>::insert(
+    const_iterator pos, InputIt first, InputIt last) -> iterator
+{
+    const size_type i = pos - begin();
+    if constexpr(is_trivially_relocatable_v<T> &&
+        std::is_base_of<std::forward_iterator_tag, Category>::value)
+    {
+        const size_type n = std::distance(first, last);
+        T *p = open_gap(i, n);
+        try
+        {
+            std::uninitialized_copy(first, last, p);
+        }
+        catch(...)
+        {
+            close_gap(i, n);
+            throw;
+        }
+        return p;
+    }
+    else
+    {
+        const size_type old_size = size();
+        append(first, last);
+        std::rotate(buf.begin() + i, buf.begin() + old_size, next);
+        return buf.begin() + i;
+    }
+}
+//----------------------------------------------------------------------------
+template<class T, class A, class G, class R, class S>
+auto autogrow_array<T,A,G,R,S>::erase(const_iterator first, const_iterator last)
+    -> iterator
+{
+    T *p = to_mutable(first), *q = to_mutable(last);
+    if(p == q) return p;
+    if constexpr(is_trivially_relocatable_v<T>)
+    {
+        for(T *it = p; it != q; ++it) buf.destroy(it);
+        close_gap(p - buf.begin(), q - p);
+    }
+    else
+    {
+        destroy_from(std::move(q, next, p));
+    }
+    auto_shrink();
+    return p;
+}
+//----------------------------------------------------------------------------
+template<class T, class A, class G, class R, class S>
+template<class InputIt>
+REALLOC4CPP_CONSTEXPR20
+void autogrow_array<T,A,G,R,S>::append_impl(
+    InputIt first, InputIt last, std::input_iterator_tag)
+{
+    // Length is unknown, nothing to precompute
+    for(; first != last; ++first) push_back(*first);
+}
+//----------------------------------------------------------------------------
+template<class T, class A, class G, class R, class S>
+template<class ForwardIt>
+REALLOC4CPP_CONSTEXPR20
+void autogrow_array<T,A,G,R,S>::append_impl(
+    ForwardIt first, ForwardIt last, std::forward_iterator_tag)
+{
+    const size_type n = std::distance(first, last);
+    grow_by(n);
+    constexpr bool contiguous =
+#if __cpp_lib_concepts
+        std::contiguous_iterator<ForwardIt>;
+#else
+        std::is_pointer<ForwardIt>::value;
+#endif
+    if constexpr(contiguous && std::is_trivially_copyable<T>::value &&
+        std::is_same<typename std::iterator_traits<ForwardIt>::value_type,
+            T>::value)
+    {
+        if(!is_constant_evaluated())
+        {
+            if(n) std::memcpy(next, std::addressof(*first), n * sizeof(T));
+            next += n;
+            return;
+        }
+    }
+    next = uninitialized_copy(first, last, next);
+}
+//----------------------------------------------------------------------------
+template<class T, class A, class G, class R, class S>
+REALLOC4CPP_CONSTEXPR20
+void autogrow_array<T,A,G,R,S>::append_n(size_type n, const T &value)
+{
+    const T v(value); // value can refer to an element of relocated buffer
+    grow_by(n);
+    next = uninitialized_fill_n(next, n, v);
+}
+//----------------------------------------------------------------------------
+template<class T, class A, class G, class R, class S>
+REALLOC4CPP_CONSTEXPR20
+void autogrow_array<T,A,G,R,S>::resize(size_type n)
+{
+    if(n <= size())
+    {
+        destroy_from(buf.begin() + n);
+        auto_shrink();
+        return;
+    }
+    grow_by(n - size());
+    next = uninitialized_value_construct_n(next, n - size());
+}
+//----------------------------------------------------------------------------
+template<class T, class A, class G, class R, class S>
+REALLOC4CPP_CONSTEXPR20
+void autogrow_array<T,A,G,R,S>::resize(size_type n, const T &value)
+{
+    if(n <= size())
+    {
+        destroy_from(buf.begin() + n);
+        auto_shrink();
+        return;
+    }
+    append_n(n - size(), value);
+}
+//----------------------------------------------------------------------------
+template<class T, class A, class G, class R, class S>
+REALLOC4CPP_CONSTEXPR20
+void autogrow_array<T,A,G,R,S>::reserve(size_type n)
+{
+    if(n <= capacity()) return;
+    const size_type least_n = n - capacity();
+    buf.capacity_remain(least_n);
+    if(buf.expand_by_at_least(least_n, least_n))
+    {
+        // AWESOME!!! Buffer was enlarged!
+        // No need to move existing elements!
+        return;
+    }
+    relocate(n);
+}
+//----------------------------------------------------------------------------
+template<class T, class A, class G, class R, class S>
+void autogrow_array<T,A,G,R,S>::shrink_to_fit()
+{
+    if(empty())
+    {
+        trim(); // frees the block
+        return;
+    }
+    // Already the smallest buffer possible for this size
+    if(buf.good_capacity(size()) >= capacity()) return;
+    if(buf.shrink_by(capacity() - size()))
+    {
+        // AWESOME!!! Buffer was narrowed!
+        // No need to move existing elements!
+    }
+    else // allocate new buffer
+        relocate(size());
+}
+//----------------------------------------------------------------------------
+template<class T, class A, class G, class R, class S>
+std::size_t autogrow_array<T,A,G,R,S>::trim(std::size_t min_slack_bytes)
+{
+    const size_type cap = capacity(), slack = cap - size();
+    if(!slack || slack * sizeof(T) < min_slack_bytes) return 0;
+    if(empty()) // nothing to keep
+    {
+        raw_buffer<T,A,S>(buf.get_allocator()).swap(buf);
+        next = buf.begin();
+        return cap * sizeof(T);
+    }
+    if(!buf.shrink_by(slack)) return 0;
+    // AWESOME!!! Buffer was narrowed!
+    return (cap - capacity()) * sizeof(T);
+}
+//----------------------------------------------------------------------------
+
+} // namespace
+
+#endif // header guard
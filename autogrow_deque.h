@@ -0,0 +1,365 @@
+#ifndef __AUTOGROW_DEQUE_H
+#define __AUTOGROW_DEQUE_H
+
+#include"raw_buffer.h"
+#include<memory>
+#include<iterator>
+#include<cassert>
+
+namespace realloc4cpp {
+
+//////////////////////////////////////////////////////////////////////////////
+// Append-only array whose elements never move: segment s holds 8 << s
+// of them, so the table of the segments has a fixed size. Growing
+// allocates the next segment and copies nothing.
+template<class E, class Allocator>
+class segmented_directory
+{
+public:
+    using size_type = std::size_t;
+private:
+    using alloc_type = typename
+        std::allocator_traits<Allocator>::template rebind_alloc<E>;
+    using traits = std::allocator_traits<alloc_type>;
+    static constexpr size_type base_bits = 3;
+    static constexpr size_type max_segments =
+        sizeof(size_type) * 8 - base_bits;
+
+    E *segments[max_segments] = {};
+    size_type size_ = 0;
+    alloc_type alloc;
+
+    static size_type segment_of(size_type i)
+    {
+        return sizeof(unsigned long long) * 8 - 1 -
+            __builtin_clzll((i >> base_bits) + 1);
+    }
+    static size_type segment_start(size_type s)
+        { return ((size_type(1) << s) - 1) << base_bits; }
+    static size_type segment_size(size_type s)
+        { return size_type(1) << (s + base_bits); }
+    E *place(size_type i) const
+    {
+        const size_type s = segment_of(i);
+        return segments[s] + (i - segment_start(s));
+    }
+public:
+    explicit segmented_directory(const Allocator &a = Allocator())
+        : alloc(a) {}
+    segmented_directory(const segmented_directory & ) = delete;
+    segmented_directory &operator=(const segmented_directory & ) = delete;
+    ~segmented_directory() { clear(); }
+
+    bool empty() const { return size_ == 0; }
+    size_type size() const { return size_; }
+
+    E &operator[](size_type i) { assert(i < size_); return *place(i); }
+    const E &operator[](size_type i) const
+        { assert(i < size_); return *place(i); }
+    E &front() { return (*this)[0]; }
+    const E &front() const { return (*this)[0]; }
+    E &back() { return (*this)[size_ - 1]; }
+    const E &back() const { return (*this)[size_ - 1]; }
+
+    // Allocates the segment of the next element: emplace_back() does not
+    // run out of memory then
+    void reserve_back()
+    {
+        const size_type s = segment_of(size_);
+        if(!segments[s])
+            segments[s] = traits::allocate(alloc, segment_size(s));
+    }
+    template<class... Args> E &emplace_back(Args &&... args)
+    {
+        reserve_back();
+        E *p = place(size_);
+        traits::construct(alloc, p, std::forward<Args>(args)...);
+        ++size_;
+        return *p;
+    }
+    // The segment is kept for the next emplace_back()
+    void pop_back()
+    {
+        assert(!empty());
+        traits::destroy(alloc, place(--size_));
+    }
+    void clear()
+    {
+        while(!empty()) pop_back();
+        for(size_type s = 0; s < max_segments && segments[s]; s++)
+        {
+            traits::deallocate(alloc, segments[s], segment_size(s));
+            segments[s] = nullptr;
+        }
+    }
+};
+//////////////////////////////////////////////////////////////////////////////
+// Append-only (at the back) segmented container. Elements live in chunks,
+// the tail chunk grows in place up to MaxChunkBytes, then a new chunk is
+// started, twice as large as the previous one up to MaxChunkBytes.
+// Elements are never relocated, so references stay valid and push_back
+// latency is bounded: the directories of the chunks are segmented too.
+//
+// Every chunk holds at least 16KiB (the smallest resizable jemalloc block),
+// so the element index is mapped to its chunk in O(1) using a table with
+// one entry per granule of that size.
+template<class T, class Allocator = std::allocator<T>,
+    std::size_t MaxChunkBytes = std::size_t(4) << 20>
+class autogrow_deque
+{
+public:
+    using value_type = T;
+    using allocator_type = Allocator;
+    using size_type = typename std::allocator_traits<Allocator>::size_type;
+private:
+    static constexpr size_type granule_bits()
+    {
+        size_type bits = 0;
+        while((size_type(2) << bits) * sizeof(T) <= (size_type(16) << 10))
+            bits++;
+        return bits;
+    }
+    static constexpr size_type gbits = granule_bits();
+    static constexpr size_type granule = size_type(1) << gbits;
+    static constexpr size_type max_chunk =
+        MaxChunkBytes / sizeof(T) > granule ? MaxChunkBytes / sizeof(T) :
+            granule;
+
+    struct chunk
+    {
+        raw_buffer<T, Allocator> buf;
+        T *last; // end of the elements
+        size_type first_index;
+
+        chunk(size_type capacity, size_type first, const Allocator &a)
+        :
+            buf(capacity, a), last(buf.begin()), first_index(first)
+        {
+        }
+        size_type size() const { return last - buf.begin(); }
+        bool full() const { return last == buf.end(); }
+    };
+    segmented_directory<chunk, Allocator> chunks;
+    segmented_directory<size_type, Allocator> granules; // -> chunk index
+    size_type size_ = 0;
+    Allocator alloc;
+
+    T *slot_for_back();
+    size_type chunk_of(size_type i) const
+    {
+        size_type k = granules[i >> gbits];
+        if(i >= chunks[k].first_index + chunks[k].size()) ++k;
+        return k;
+    }
+
+    template<bool Const> class iterator_impl;
+public:
+    using iterator = iterator_impl<false>;
+    using const_iterator = iterator_impl<true>;
+
+    autogrow_deque() = default;
+    explicit autogrow_deque(const Allocator &a)
+        : chunks(a), granules(a), alloc(a) {}
+    autogrow_deque(const autogrow_deque & ) = delete;
+    autogrow_deque &operator=(const autogrow_deque & ) = delete;
+    ~autogrow_deque() { clear(); }
+
+    allocator_type get_allocator() const { return alloc; }
+
+    bool empty() const { return size_ == 0; }
+    size_type size() const { return size_; }
+    size_type chunk_count() const { return chunks.size(); }
+
+    T &operator[](size_type i)
+    {
+        assert(i < size_);
+        const chunk &c = chunks[chunk_of(i)];
+        return c.buf.begin()[i - c.first_index];
+    }
+    const T &operator[](size_type i) const
+    {
+        return const_cast<autogrow_deque &>(*this)[i];
+    }
+    T &back() { assert(!empty()); return chunks.back().last[-1]; }
+    const T &back() const { assert(!empty()); return chunks.back().last[-1]; }
+    T &front() { assert(!empty()); return *chunks.front().buf.begin(); }
+    const T &front() const
+        { assert(!empty()); return *chunks.front().buf.begin(); }
+
+    iterator begin();
+    iterator end();
+    const_iterator begin() const;
+    const_iterator end() const;
+
+    // Calls f(first, last) for the elements of every chunk in order
+    template<class F> void for_each_chunk(F f)
+    {
+        for(size_type k = 0; k < chunks.size(); k++)
+            f(chunks[k].buf.begin(), chunks[k].last);
+    }
+    template<class F> void for_each_chunk(F f) const
+    {
+        for(size_type k = 0; k < chunks.size(); k++)
+            f(const_cast<const T *>(chunks[k].buf.begin()),
+                const_cast<const T *>(chunks[k].last));
+    }
+
+    void push_back(const T &v) { emplace_back(v); }
+    void push_back(T &&v) { emplace_back(std::move(v)); }
+    template<class... Args> T &emplace_back(Args &&... );
+    void pop_back();
+    void clear();
+};
+//////////////////////////////////////////////////////////////////////////////
+template<class T, class A, std::size_t M>
+template<bool Const>
+class autogrow_deque<T,A,M>::iterator_impl
+{
+    using deque = std::conditional_t<Const,
+        const autogrow_deque, autogrow_deque>;
+    deque *d = nullptr;
+    size_type k = 0; // chunk index
+    T *p = nullptr;
+
+    friend class autogrow_deque;
+    friend class iterator_impl<!Const>;
+    iterator_impl(deque *d, size_type k, T *p) : d(d), k(k), p(p) {}
+public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = std::conditional_t<Const, const T *, T *>;
+    using reference = std::conditional_t<Const, const T &, T &>;
+
+    iterator_impl() = default;
+    template<bool C2, class = std::enable_if_t<Const && !C2>>
+    iterator_impl(const iterator_impl<C2> &o) : d(o.d), k(o.k), p(o.p) {}
+
+    reference operator*() const { return *p; }
+    pointer operator->() const { return p; }
+
+    iterator_impl &operator++()
+    {
+        if(++p == d->chunks[k].last && k + 1 < d->chunks.size())
+            p = d->chunks[++k].buf.begin();
+        return *this;
+    }
+    iterator_impl operator++(int) { auto t = *this; ++*this; return t; }
+    iterator_impl &operator--()
+    {
+        if(p == d->chunks[k].buf.begin()) p = d->chunks[--k].last;
+        --p;
+        return *this;
+    }
+    iterator_impl operator--(int) { auto t = *this; --*this; return t; }
+
+    friend bool operator==(const iterator_impl &a, const iterator_impl &b)
+    {
+        return a.p == b.p;
+    }
+    friend bool operator!=(const iterator_impl &a, const iterator_impl &b)
+    {
+        return a.p != b.p;
+    }
+};
+//////////////////////////////////////////////////////////////////////////////
+//----------------------------------------------------------------------------
+template<class T, class A, std::size_t M>
+auto autogrow_deque<T,A,M>::begin() -> iterator
+{
+    if(empty()) return end();
+    return iterator(this, 0, chunks.front().buf.begin());
+}
+//----------------------------------------------------------------------------
+template<class T, class A, std::size_t M>
+auto autogrow_deque<T,A,M>::end() -> iterator
+{
+    if(chunks.empty()) return iterator(this, 0, nullptr);
+    return iterator(this, chunks.size() - 1, chunks.back().last);
+}
+//----------------------------------------------------------------------------
+template<class T, class A, std::size_t M>
+auto autogrow_deque<T,A,M>::begin() const -> const_iterator
+{
+    return const_cast<autogrow_deque &>(*this).begin();
+}
+//----------------------------------------------------------------------------
+template<class T, class A, std::size_t M>
+auto autogrow_deque<T,A,M>::end() const -> const_iterator
+{
+    return const_cast<autogrow_deque &>(*this).end();
+}
+//----------------------------------------------------------------------------
+// Returns the place for the new last element
+template<class T, class A, std::size_t M>
+T *autogrow_deque<T,A,M>::slot_for_back()
+{
+    // emplace_back() must not fail after the element is constructed
+    if(size_ % granule == 0) granules.reserve_back();
+    if(!chunks.empty())
+    {
+        chunk &c = chunks.back();
+        if(!c.full()) return c.last;
+        const size_type cap = c.buf.capacity();
+        if(cap < max_chunk && c.buf.expand_by_at_least(
+            std::min(cap, max_chunk - cap), 1))
+        {
+            // AWESOME!!! Chunk was enlarged in place!
+            return c.last;
+        }
+    }
+    // Start the new chunk, no elements are moved. Doubling keeps the
+    // chunks few when the allocator cannot expand them in place.
+    const size_type cap = chunks.empty() ? granule :
+        std::min(chunks.back().buf.capacity() * 2, max_chunk);
+    chunks.emplace_back(cap, size_, alloc);
+    return chunks.back().last;
+}
+//----------------------------------------------------------------------------
+template<class T, class A, std::size_t M>
+template<class... Args>
+T &autogrow_deque<T,A,M>::emplace_back(Args &&... args)
+{
+    T *p = slot_for_back();
+    chunk &c = chunks.back();
+    try
+    {
+        c.buf.construct(p, std::forward<Args>(args)...);
+    }
+    catch(...)
+    {
+        if(c.size() == 0 && chunks.size() > 1) chunks.pop_back();
+        throw;
+    }
+    ++c.last;
+    if(size_++ % granule == 0) granules.emplace_back(chunks.size() - 1);
+    return *p;
+}
+//----------------------------------------------------------------------------
+template<class T, class A, std::size_t M>
+void autogrow_deque<T,A,M>::pop_back()
+{
+    assert(!empty());
+    chunk &c = chunks.back();
+    c.buf.destroy(--c.last);
+    if(--size_ % granule == 0) granules.pop_back();
+    if(c.size() == 0 && chunks.size() > 1) chunks.pop_back();
+}
+//----------------------------------------------------------------------------
+template<class T, class A, std::size_t M>
+void autogrow_deque<T,A,M>::clear()
+{
+    for(size_type k = 0; k < chunks.size(); k++)
+    {
+        chunk &c = chunks[k];
+        for(T *p = c.buf.begin(); p != c.last; ++p) c.buf.destroy(p);
+    }
+    chunks.clear();
+    granules.clear();
+    size_ = 0;
+}
+//----------------------------------------------------------------------------
+
+} // namespace
+
+#endif // header guard
@@ -0,0 +1,500 @@
+#ifndef __AUTOGROW_HASH_MAP_H
+#define __AUTOGROW_HASH_MAP_H
+
+#include"raw_buffer.h"
+#include<functional>
+#include<algorithm>
+#include<tuple>
+#include<iterator>
+#include<utility>
+#include<cstdint>
+#include<cstring>
+#include<new>
+#include<stdexcept>
+#include<cassert>
+
+namespace realloc4cpp {
+
+//////////////////////////////////////////////////////////////////////////////
+// Open-addressing (linear probing) hash map, all the buckets live in one
+// raw_buffer. When the table grows the buffer is expanded in place if
+// possible and the elements are rehashed inside it: no second table is
+// allocated, so the peak memory is not doubled. Falls back to the usual
+// rehash into the new buffer otherwise.
+//
+// Bucket count is not a power of 2 (any capacity the allocator gives),
+// the hash is mixed and mapped to the bucket with multiply-high.
+//
+// The in-place rehash moves the elements inside the buffer, so it is used
+// only if value_type can be moved without exceptions: nothrow
+// move-constructible or Key and T are trivially relocatable.
+// Erase uses backward shift, tombstones are left only by erase(iterator)
+// in the cluster wrapped around the table end. The other value types
+// (moving pair<const Key, T> copies the key) are erased with tombstones.
+template<class Key, class T, class Hash = std::hash<Key>,
+    class KeyEqual = std::equal_to<Key>,
+    class Allocator = std::allocator<std::pair<const Key, T>>>
+class autogrow_hash_map : private Hash, private KeyEqual
+{
+public:
+    using key_type = Key;
+    using mapped_type = T;
+    using value_type = std::pair<const Key, T>;
+    using size_type = std::size_t;
+    using hasher = Hash;
+    using key_equal = KeyEqual;
+    using allocator_type = Allocator;
+private:
+    // deleted_slot is the rare tombstone, see erase_slot()
+    enum : unsigned char { empty_slot, full_slot, deleted_slot, pending_slot };
+    struct slot
+    {
+        alignas(value_type) unsigned char storage[sizeof(value_type)];
+        unsigned char state;
+
+        value_type &value()
+        {
+            return *std::launder(reinterpret_cast<value_type *>(storage));
+        }
+        bool full() const { return state == full_slot; }
+    };
+    using slot_allocator = typename
+        std::allocator_traits<Allocator>::template rebind_alloc<slot>;
+    using buffer = raw_buffer<slot, slot_allocator>;
+
+    static constexpr bool relocatable_in_place =
+        std::is_nothrow_move_constructible<value_type>::value ||
+        (is_trivially_relocatable_v<Key> && is_trivially_relocatable_v<T>);
+
+    buffer buf;
+    size_type size_ = 0, deleted = 0;
+
+    const Hash &hash() const { return *this; }
+    const KeyEqual &eq() const { return *this; }
+    static size_type home(size_type h, size_type buckets)
+    {
+        const std::uint64_t x = std::uint64_t(h) * 0x9E3779B97F4A7C15ull;
+        __extension__ typedef unsigned __int128 uint128; // for -Wpedantic
+        return size_type(uint128(x) * buckets >> 64);
+    }
+    size_type home_of(slot &s) const
+    {
+        return home(hash()(s.value().first), bucket_count());
+    }
+    size_type next(size_type i) const
+    {
+        return ++i == bucket_count() ? 0 : i;
+    }
+    static void relocate(slot &to, slot &from) noexcept;
+    static void swap_values(slot &a, slot &b) noexcept;
+    static void mark_empty(slot *first, slot *last)
+    {
+        for(; first != last; ++first) first->state = empty_slot;
+    }
+
+    // Buckets to hold n elements without exceeding max_load_factor()
+    static size_type buckets_for(size_type n)
+    {
+        return n / 3 * 4 + n % 3 * 4 / 3 + 1;
+    }
+    slot *find_slot(const Key & ) const;
+    template<class KeyArg, class... Args>
+    std::pair<slot *, bool> emplace_key(KeyArg && , Args &&... );
+    void erase_slot(size_type , bool );
+    void grow(size_type );
+    void rehash_in_place(size_type );
+    void rehash_to(size_type );
+
+    template<bool Const> class iterator_impl;
+public:
+    using iterator = iterator_impl<false>;
+    using const_iterator = iterator_impl<true>;
+
+    autogrow_hash_map() = default;
+    explicit autogrow_hash_map(size_type buckets,
+        const Hash &h = Hash(), const KeyEqual &e = KeyEqual(),
+        const Allocator &a = Allocator())
+        : Hash(h), KeyEqual(e), buf(slot_allocator(a)) { rehash(buckets); }
+    explicit autogrow_hash_map(const Allocator &a) : buf(slot_allocator(a)) {}
+    autogrow_hash_map(const autogrow_hash_map & ) = delete;
+    autogrow_hash_map &operator=(const autogrow_hash_map & ) = delete;
+    ~autogrow_hash_map() { clear(); }
+
+    allocator_type get_allocator() const
+        { return allocator_type(buf.get_allocator()); }
+    hasher hash_function() const { return hash(); }
+    key_equal key_eq() const { return eq(); }
+
+    bool empty() const { return size_ == 0; }
+    size_type size() const { return size_; }
+    size_type bucket_count() const { return buf.capacity(); }
+    float load_factor() const
+        { return bucket_count() ? float(size_) / bucket_count() : 0; }
+    static constexpr float max_load_factor() { return 0.75f; }
+
+    iterator begin();
+    iterator end();
+    const_iterator begin() const;
+    const_iterator end() const;
+
+    iterator find(const Key &k);
+    const_iterator find(const Key &k) const
+        { return const_cast<autogrow_hash_map &>(*this).find(k); }
+    size_type count(const Key &k) const { return find_slot(k) ? 1 : 0; }
+    bool contains(const Key &k) const { return find_slot(k); }
+    T &at(const Key & );
+    const T &at(const Key &k) const
+        { return const_cast<autogrow_hash_map &>(*this).at(k); }
+    T &operator[](const Key &k) { return try_emplace(k).first->second; }
+    T &operator[](Key &&k) { return try_emplace(std::move(k)).first->second; }
+
+    template<class... Args>
+    std::pair<iterator,bool> try_emplace(const Key &k, Args &&... args)
+    {
+        auto r = emplace_key(k, std::forward<Args>(args)...);
+        return {iterator(r.first, buf.end()), r.second};
+    }
+    template<class... Args>
+    std::pair<iterator,bool> try_emplace(Key &&k, Args &&... args)
+    {
+        auto r = emplace_key(std::move(k), std::forward<Args>(args)...);
+        return {iterator(r.first, buf.end()), r.second};
+    }
+    std::pair<iterator,bool> insert(const value_type &v)
+        { return try_emplace(v.first, v.second); }
+    std::pair<iterator,bool> insert(value_type &&v)
+        { return try_emplace(v.first, std::move(v.second)); }
+
+    size_type erase(const Key & );
+    iterator erase(const_iterator );
+    void clear();
+
+    // Buckets for at least n elements
+    void reserve(size_type n) { rehash(buckets_for(n)); }
+    void rehash(size_type );
+};
+//////////////////////////////////////////////////////////////////////////////
+template<class K, class T, class H, class E, class A>
+template<bool Const>
+class autogrow_hash_map<K,T,H,E,A>::iterator_impl
+{
+    slot *s = nullptr, *last = nullptr;
+
+    friend class autogrow_hash_map;
+    friend class iterator_impl<!Const>;
+    iterator_impl(slot *s, slot *last) : s(s), last(last) { skip(); }
+    void skip() { while(s != last && !s->full()) ++s; }
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = typename autogrow_hash_map::value_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = std::conditional_t<Const,
+        const value_type *, value_type *>;
+    using reference = std::conditional_t<Const,
+        const value_type &, value_type &>;
+
+    iterator_impl() = default;
+    template<bool C2, class = std::enable_if_t<Const && !C2>>
+    iterator_impl(const iterator_impl<C2> &o) : s(o.s), last(o.last) {}
+
+    reference operator*() const { return s->value(); }
+    pointer operator->() const { return &s->value(); }
+
+    iterator_impl &operator++() { ++s; skip(); return *this; }
+    iterator_impl operator++(int) { auto t = *this; ++*this; return t; }
+
+    friend bool operator==(const iterator_impl &a, const iterator_impl &b)
+    {
+        return a.s == b.s;
+    }
+    friend bool operator!=(const iterator_impl &a, const iterator_impl &b)
+    {
+        return a.s != b.s;
+    }
+};
+//////////////////////////////////////////////////////////////////////////////
+//----------------------------------------------------------------------------
+template<class K, class T, class H, class E, class A>
+auto autogrow_hash_map<K,T,H,E,A>::begin() -> iterator
+{
+    return iterator(buf.begin(), buf.end());
+}
+//----------------------------------------------------------------------------
+template<class K, class T, class H, class E, class A>
+auto autogrow_hash_map<K,T,H,E,A>::end() -> iterator
+{
+    return iterator(buf.end(), buf.end());
+}
+//----------------------------------------------------------------------------
+template<class K, class T, class H, class E, class A>
+auto autogrow_hash_map<K,T,H,E,A>::begin() const -> const_iterator
+{
+    return const_cast<autogrow_hash_map &>(*this).begin();
+}
+//----------------------------------------------------------------------------
+template<class K, class T, class H, class E, class A>
+auto autogrow_hash_map<K,T,H,E,A>::end() const -> const_iterator
+{
+    return const_cast<autogrow_hash_map &>(*this).end();
+}
+//----------------------------------------------------------------------------
+// Moves the value, from becomes empty
+template<class K, class T, class H, class E, class A>
+void autogrow_hash_map<K,T,H,E,A>::relocate(slot &to, slot &from) noexcept
+{
+    static_assert(relocatable_in_place);
+    if constexpr(is_trivially_relocatable_v<K> &&
+        is_trivially_relocatable_v<T>)
+        std::memcpy(to.storage, from.storage, sizeof(value_type));
+    else
+    {
+        ::new(static_cast<void *>(to.storage))
+            value_type(std::move(from.value()));
+        from.value().~value_type();
+    }
+    to.state = from.state;
+    from.state = empty_slot;
+}
+//----------------------------------------------------------------------------
+template<class K, class T, class H, class E, class A>
+void autogrow_hash_map<K,T,H,E,A>::swap_values(slot &a, slot &b) noexcept
+{
+    slot tmp;
+    relocate(tmp, a);
+    relocate(a, b);
+    relocate(b, tmp);
+}
+//----------------------------------------------------------------------------
+template<class K, class T, class H, class E, class A>
+auto autogrow_hash_map<K,T,H,E,A>::find_slot(const K &k) const -> slot *
+{
+    if(empty()) return nullptr;
+    slot *slots = const_cast<slot *>(buf.begin());
+    for(size_type i = home(hash()(k), bucket_count());; i = next(i))
+    {
+        if(slots[i].state == empty_slot) return nullptr;
+        if(slots[i].full() && eq()(slots[i].value().first, k))
+            return slots + i;
+    }
+}
+//----------------------------------------------------------------------------
+template<class K, class T, class H, class E, class A>
+auto autogrow_hash_map<K,T,H,E,A>::find(const K &k) -> iterator
+{
+    slot *s = find_slot(k);
+    return s ? iterator(s, buf.end()) : end();
+}
+//----------------------------------------------------------------------------
+template<class K, class T, class H, class E, class A>
+T &autogrow_hash_map<K,T,H,E,A>::at(const K &k)
+{
+    slot *s = find_slot(k);
+    if(!s) throw std::out_of_range("autogrow_hash_map::at()");
+    return s->value().second;
+}
+//----------------------------------------------------------------------------
+template<class K, class T, class H, class E, class A>
+template<class KeyArg, class... Args>
+auto autogrow_hash_map<K,T,H,E,A>::emplace_key(KeyArg &&k, Args &&... args)
+    -> std::pair<slot *, bool>
+{
+    if(slot *s = find_slot(k)) return {s, false};
+    if(buckets_for(size_ + deleted + 1) > bucket_count())
+        grow(buckets_for(size_ + 1));
+    size_type i = home(hash()(k), bucket_count());
+    while(buf.begin()[i].full()) i = next(i);
+    slot &s = buf.begin()[i];
+    const bool tombstone = s.state == deleted_slot;
+    ::new(static_cast<void *>(s.storage)) value_type(std::piecewise_construct,
+        std::forward_as_tuple(std::forward<KeyArg>(k)),
+        std::forward_as_tuple(std::forward<Args>(args)...));
+    // After the construction: the slot stays a tombstone if it throws
+    if(tombstone) --deleted;
+    s.state = full_slot;
+    ++size_;
+    return {&s, true};
+}
+//----------------------------------------------------------------------------
+// Backward shift: the elements probed past the hole are pulled up.
+// While iterating, an element already visited (behind the table end) is
+// never moved ahead of the iterator: the hole becomes a tombstone instead.
+template<class K, class T, class H, class E, class A>
+void autogrow_hash_map<K,T,H,E,A>::erase_slot(size_type pos, bool iterating)
+{
+    slot *slots = buf.begin();
+    slots[pos].value().~value_type();
+    --size_;
+    if constexpr(!relocatable_in_place)
+    {
+        // No shift: a tombstone unless the probe sequences end here anyway
+        if(slots[next(pos)].state == empty_slot) slots[pos].state = empty_slot;
+        else
+        {
+            slots[pos].state = deleted_slot;
+            ++deleted;
+        }
+    }
+    else
+    {
+        const size_type n = bucket_count();
+        const auto dist = [n](size_type from, size_type to) {
+            return to >= from ? to - from : to + n - from;
+        };
+        size_type i = pos;
+        unsigned char hole = empty_slot;
+        for(size_type j = next(i); slots[j].state != empty_slot; j = next(j))
+        {
+            if(slots[j].state == deleted_slot) // probe sequences go through it
+            {
+                hole = deleted_slot;
+                break;
+            }
+            if(dist(home_of(slots[j]), j) >= dist(i, j))
+            {
+                if(iterating && j < pos && i >= pos)
+                {
+                    hole = deleted_slot;
+                    break;
+                }
+                relocate(slots[i], slots[j]);
+                i = j;
+            }
+        }
+        slots[i].state = hole;
+        if(hole == deleted_slot) ++deleted;
+    }
+}
+//----------------------------------------------------------------------------
+template<class K, class T, class H, class E, class A>
+auto autogrow_hash_map<K,T,H,E,A>::erase(const_iterator it) -> iterator
+{
+    erase_slot(it.s - buf.begin(), true);
+    // Now the next element or the hole is there
+    return iterator(it.s, buf.end());
+}
+//----------------------------------------------------------------------------
+template<class K, class T, class H, class E, class A>
+auto autogrow_hash_map<K,T,H,E,A>::erase(const K &k) -> size_type
+{
+    slot *s = find_slot(k);
+    if(!s) return 0;
+    erase_slot(s - buf.begin(), false);
+    return 1;
+}
+//----------------------------------------------------------------------------
+template<class K, class T, class H, class E, class A>
+void autogrow_hash_map<K,T,H,E,A>::clear()
+{
+    for(slot *s = buf.begin(); s != buf.end(); ++s)
+    {
+        if(s->full()) s->value().~value_type();
+        s->state = empty_slot;
+    }
+    size_ = deleted = 0;
+}
+//----------------------------------------------------------------------------
+template<class K, class T, class H, class E, class A>
+void autogrow_hash_map<K,T,H,E,A>::rehash(size_type n)
+{
+    if(n > bucket_count()) grow(n);
+}
+//----------------------------------------------------------------------------
+// Makes at least n buckets, usually doubles their number. Only rebuilds
+// the table if the tombstones fill most of it.
+template<class K, class T, class H, class E, class A>
+void autogrow_hash_map<K,T,H,E,A>::grow(size_type n)
+{
+    const size_type old_n = bucket_count();
+    if(n <= old_n / 2)
+    {
+        if constexpr(relocatable_in_place) rehash_in_place(old_n);
+        else rehash_to(old_n);
+        return;
+    }
+    // Accept 1.5x at least, the rehash is linear anyway
+    const size_type least_n = std::max(n, old_n + old_n / 2) - old_n;
+    n = std::max({n, old_n * 2, size_type(16)});
+    if constexpr(relocatable_in_place)
+    {
+        if(buf.expand_by_at_least(n - old_n, least_n))
+        {
+            // AWESOME!!! Table was enlarged!
+            // No need to allocate the second one!
+            rehash_in_place(old_n);
+            return;
+        }
+    }
+    buf.capacity_remain(n - old_n);
+    rehash_to(n);
+}
+//----------------------------------------------------------------------------
+// Buckets [old_n, bucket_count()) are new and uninitialized.
+// All the elements are marked pending (tombstones are dropped), then
+// every pending element goes to the first bucket of its probe sequence
+// that is empty or pending; the pending one met there is swapped out and
+// placed next. Placed elements never move again, so every probe sequence
+// stays unbroken.
+template<class K, class T, class H, class E, class A>
+void autogrow_hash_map<K,T,H,E,A>::rehash_in_place(size_type old_n)
+{
+    slot *slots = buf.begin();
+    mark_empty(slots + old_n, buf.end());
+    for(size_type i = 0; i < old_n; i++)
+        slots[i].state = slots[i].full() ? pending_slot : empty_slot;
+    deleted = 0;
+    for(size_type i = 0; i < old_n; i++)
+        while(slots[i].state == pending_slot)
+        {
+            size_type j = home_of(slots[i]);
+            while(j != i && slots[j].full()) j = next(j);
+            if(j == i) slots[i].state = full_slot; // already in place
+            else if(slots[j].state == empty_slot)
+            {
+                relocate(slots[j], slots[i]);
+                slots[j].state = full_slot;
+            }
+            else // pending, i gets its element
+            {
+                swap_values(slots[i], slots[j]);
+                slots[j].state = full_slot;
+            }
+        }
+}
+//----------------------------------------------------------------------------
+// The usual rehash to the new buffer, the table is intact on exception
+template<class K, class T, class H, class E, class A>
+void autogrow_hash_map<K,T,H,E,A>::rehash_to(size_type n)
+{
+    buffer new_buf(n, buf.get_allocator());
+    slot *new_slots = new_buf.begin();
+    const size_type new_n = new_buf.capacity();
+    mark_empty(new_slots, new_buf.end());
+    slot *s = buf.begin();
+    try
+    {
+        for(; s != buf.end(); ++s)
+        {
+            if(!s->full()) continue;
+            size_type i = home(hash()(s->value().first), new_n);
+            while(new_slots[i].full()) if(++i == new_n) i = 0;
+            ::new(static_cast<void *>(new_slots[i].storage))
+                value_type(std::move_if_noexcept(s->value()));
+            new_slots[i].state = full_slot;
+        }
+    }
+    catch(...)
+    {
+        for(slot *p = new_slots; p != new_buf.end(); ++p)
+            if(p->full()) p->value().~value_type();
+        throw;
+    }
+    const size_type count = size_;
+    clear();
+    size_ = count;
+    buf.swap(new_buf);
+}
+//----------------------------------------------------------------------------
+
+} // namespace
+
+#endif // header guard
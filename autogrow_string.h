@@ -0,0 +1,298 @@
+#ifndef __AUTOGROW_STRING_H
+#define __AUTOGROW_STRING_H
+
+#include"raw_buffer.h"
+#include<string>
+#include<string_view>
+#include<functional>
+#include<ostream>
+#include<cassert>
+
+namespace realloc4cpp {
+
+//////////////////////////////////////////////////////////////////////////////
+// std::basic_string-like string with small-string optimisation.
+// Long strings live in raw_buffer and grow/shrink in place when possible.
+template<class CharT, class Traits = std::char_traits<CharT>,
+    class Allocator = std::allocator<CharT>>
+class autogrow_string
+{
+public:
+    using traits_type = Traits;
+    using value_type = CharT;
+    using allocator_type = Allocator;
+    using size_type = typename std::allocator_traits<Allocator>::size_type;
+    using view_type = std::basic_string_view<CharT, Traits>;
+    using iterator = CharT *;
+    using const_iterator = const CharT *;
+    static constexpr size_type npos = size_type(-1);
+private:
+    using buffer = raw_buffer<CharT, Allocator>;
+    // Fits 15 chars for char
+    static constexpr size_type sso_capacity =
+        (16 + sizeof(CharT) - 1) / sizeof(CharT) - 1;
+
+    buffer buf; // empty in SSO mode
+    size_type len = 0;
+    CharT local[sso_capacity + 1] = {};
+
+    bool is_local() const { return !buf.begin(); }
+    void set_length(size_type n)
+    {
+        len = n;
+        Traits::assign(data()[n], CharT());
+    }
+    bool aliases(const CharT *s) const
+    {
+        std::less_equal<const CharT *> le;
+        return le(data(), s) && le(s, data() + len);
+    }
+    void grow_by(size_type , bool exact = false);
+public:
+    autogrow_string() = default;
+    explicit autogrow_string(const Allocator &a) : buf(a) {}
+    autogrow_string(view_type s, const Allocator &a = Allocator())
+        : buf(a) { append(s); }
+    autogrow_string(const CharT *s, const Allocator &a = Allocator())
+        : buf(a) { append(s); }
+    autogrow_string(size_type n, CharT ch, const Allocator &a = Allocator())
+        : buf(a) { append(n, ch); }
+    autogrow_string(const autogrow_string &o)
+        : buf(o.get_allocator()) { append(o); }
+    autogrow_string(autogrow_string &&o) noexcept;
+    ~autogrow_string() = default;
+
+    autogrow_string &operator=(const autogrow_string &o)
+    {
+        if(this != &o) assign(o);
+        return *this;
+    }
+    autogrow_string &operator=(autogrow_string &&o) noexcept;
+    autogrow_string &operator=(view_type s) { return assign(s); }
+    autogrow_string &operator=(const CharT *s) { return assign(s); }
+    autogrow_string &assign(view_type s);
+
+    allocator_type get_allocator() const { return buf.get_allocator(); }
+
+    bool empty() const { return len == 0; }
+    size_type size() const { return len; }
+    size_type length() const { return len; }
+    size_type max_size() const { return buf.max_capacity() - 1; }
+    size_type capacity() const
+    {
+        return is_local() ? sso_capacity : buf.capacity() - 1;
+    }
+
+    CharT *data() { return is_local() ? local : buf.begin(); }
+    const CharT *data() const { return is_local() ? local : buf.begin(); }
+    const CharT *c_str() const { return data(); }
+    operator view_type() const { return view_type(data(), len); }
+
+    CharT &operator[](size_type i) { assert(i <= len); return data()[i]; }
+    const CharT &operator[](size_type i) const
+        { assert(i <= len); return data()[i]; }
+    CharT &back() { assert(!empty()); return data()[len - 1]; }
+    const CharT &back() const { assert(!empty()); return data()[len - 1]; }
+
+    iterator begin() { return data(); }
+    iterator end() { return data() + len; }
+    const_iterator begin() const { return data(); }
+    const_iterator end() const { return data() + len; }
+
+    autogrow_string &append(const CharT * , size_type );
+    autogrow_string &append(view_type s) { return append(s.data(), s.size()); }
+    autogrow_string &append(const CharT *s)
+        { return append(s, Traits::length(s)); }
+    autogrow_string &append(size_type , CharT );
+    void push_back(CharT ch) { append(1, ch); }
+    void pop_back() { assert(!empty()); set_length(len - 1); }
+
+    autogrow_string &operator+=(view_type s) { return append(s); }
+    autogrow_string &operator+=(const CharT *s) { return append(s); }
+    autogrow_string &operator+=(CharT ch) { push_back(ch); return *this; }
+
+    void reserve(size_type );
+    void resize(size_type n, CharT ch = CharT());
+    void clear() { set_length(0); }
+    void shrink_to_fit();
+
+    void swap(autogrow_string &o) noexcept
+    {
+        autogrow_string tmp(std::move(o));
+        o = std::move(*this);
+        *this = std::move(tmp);
+    }
+};
+//////////////////////////////////////////////////////////////////////////////
+//----------------------------------------------------------------------------
+template<class C, class T, class A>
+autogrow_string<C,T,A>::autogrow_string(autogrow_string &&o) noexcept
+:
+    buf(std::move(o.buf)), len(o.len)
+{
+    if(is_local()) T::copy(local, o.local, len + 1);
+    o.set_length(0);
+}
+//----------------------------------------------------------------------------
+template<class C, class T, class A>
+autogrow_string<C,T,A> &autogrow_string<C,T,A>::operator=(
+    autogrow_string &&o) noexcept
+{
+    if(this == &o) return *this;
+    buf.swap(o.buf);
+    std::swap(len, o.len);
+    if(is_local()) T::copy(local, o.local, len + 1);
+    o.clear(); // o has our old buffer now
+    return *this;
+}
+//----------------------------------------------------------------------------
+template<class C, class T, class A>
+autogrow_string<C,T,A> &autogrow_string<C,T,A>::assign(view_type s)
+{
+    if(aliases(s.data())) // exotic case: the part of itself
+    {
+        T::move(data(), s.data(), s.size());
+        set_length(s.size());
+        return *this;
+    }
+    clear();
+    return append(s);
+}
+//----------------------------------------------------------------------------
+// Makes room for n more chars (and the terminator)
+template<class C, class T, class A>
+void autogrow_string<C,T,A>::grow_by(size_type n, bool exact)
+{
+    const size_type cap = capacity();
+    if(n <= cap - len) return;
+    const size_type least_n = n - (cap - len);
+    const size_type cap_remain = buf.capacity_remain(least_n);
+    const size_type add_cap = exact ? least_n :
+        std::min(std::max(cap, least_n), cap_remain);
+    if(!is_local() && buf.expand_by_at_least(add_cap, least_n))
+    {
+        // AWESOME!!! Buffer was enlarged!
+        // No need to copy the string!
+        return;
+    }
+    // The terminator is not included in capacity()
+    buffer new_buf(cap + 1 + add_cap, buf.get_allocator());
+    T::copy(new_buf.begin(), data(), len + 1);
+    buf.swap(new_buf);
+}
+//----------------------------------------------------------------------------
+template<class C, class T, class A>
+autogrow_string<C,T,A> &autogrow_string<C,T,A>::append(
+    const C *s, size_type n)
+{
+    if(aliases(s)) // s can be moved by grow_by()
+    {
+        const size_type off = s - data();
+        grow_by(n);
+        s = data() + off;
+    }
+    else grow_by(n);
+    T::copy(data() + len, s, n);
+    set_length(len + n);
+    return *this;
+}
+//----------------------------------------------------------------------------
+template<class C, class T, class A>
+autogrow_string<C,T,A> &autogrow_string<C,T,A>::append(size_type n, C ch)
+{
+    grow_by(n);
+    T::assign(data() + len, n, ch);
+    set_length(len + n);
+    return *this;
+}
+//----------------------------------------------------------------------------
+template<class C, class T, class A>
+void autogrow_string<C,T,A>::reserve(size_type n)
+{
+    if(n > len) grow_by(n - len, true);
+}
+//----------------------------------------------------------------------------
+template<class C, class T, class A>
+void autogrow_string<C,T,A>::resize(size_type n, C ch)
+{
+    if(n > len) append(n - len, ch);
+    else set_length(n);
+}
+//----------------------------------------------------------------------------
+template<class C, class T, class A>
+void autogrow_string<C,T,A>::shrink_to_fit()
+{
+    if(is_local()) return;
+    if(len <= sso_capacity) // back to SSO mode
+    {
+        T::copy(local, buf.begin(), len + 1);
+        buffer(buf.get_allocator()).swap(buf);
+        return;
+    }
+    // Already the smallest buffer possible for this length
+    if(buf.good_capacity(len + 1) >= buf.capacity()) return;
+    if(buf.shrink_by(buf.capacity() - (len + 1)))
+    {
+        // AWESOME!!! Buffer was narrowed!
+        // No need to copy the string!
+    }
+    else // allocate new buffer
+    {
+        buffer new_buf(len + 1, buf.get_allocator());
+        T::copy(new_buf.begin(), buf.begin(), len + 1);
+        buf.swap(new_buf);
+    }
+}
+//----------------------------------------------------------------------------
+template<class C, class T, class A>
+inline bool operator==(const autogrow_string<C,T,A> &a,
+    std::basic_string_view<C,T> b)
+{
+    return std::basic_string_view<C,T>(a) == b;
+}
+template<class C, class T, class A>
+inline bool operator!=(const autogrow_string<C,T,A> &a,
+    std::basic_string_view<C,T> b)
+{
+    return !(a == b);
+}
+template<class C, class T, class A>
+inline bool operator==(const autogrow_string<C,T,A> &a, const C *b)
+{
+    return std::basic_string_view<C,T>(a) == b;
+}
+template<class C, class T, class A>
+inline bool operator!=(const autogrow_string<C,T,A> &a, const C *b)
+{
+    return !(a == b);
+}
+template<class C, class T, class A>
+inline bool operator==(const autogrow_string<C,T,A> &a,
+    const autogrow_string<C,T,A> &b)
+{
+    return a == std::basic_string_view<C,T>(b);
+}
+template<class C, class T, class A>
+inline bool operator!=(const autogrow_string<C,T,A> &a,
+    const autogrow_string<C,T,A> &b)
+{
+    return !(a == b);
+}
+template<class C, class T, class A>
+inline bool operator<(const autogrow_string<C,T,A> &a,
+    const autogrow_string<C,T,A> &b)
+{
+    return std::basic_string_view<C,T>(a) < std::basic_string_view<C,T>(b);
+}
+//----------------------------------------------------------------------------
+template<class C, class T, class A>
+inline std::basic_ostream<C,T> &operator<<(
+    std::basic_ostream<C,T> &os, const autogrow_string<C,T,A> &s)
+{
+    return os << std::basic_string_view<C,T>(s);
+}
+//----------------------------------------------------------------------------
+
+} // namespace
+
+#endif // header guard
@@ -0,0 +1,46 @@
+#ifndef __BACKEND_REALLOCATOR_H
+#define __BACKEND_REALLOCATOR_H
+
+//////////////////////////////////////////////////////////////////////////////
+// backend_reallocator<T> is the reallocator of the malloc the program is
+// linked with, chosen at build time by one of
+//   -DREALLOC4CPP_MIMALLOC (link -lmimalloc)
+//   -DREALLOC4CPP_TCMALLOC (link -ltcmalloc)
+//   -DREALLOC4CPP_GLIBC
+// jemalloc reallocator is used by default.
+#if defined(REALLOC4CPP_MIMALLOC) + defined(REALLOC4CPP_TCMALLOC) + \
+    defined(REALLOC4CPP_GLIBC) > 1
+#error "Only one REALLOC4CPP_* backend can be selected"
+#endif
+
+#if defined(REALLOC4CPP_MIMALLOC)
+#include"mimalloc_reallocator.h"
+#define REALLOC4CPP_BACKEND mimalloc_reallocator
+#define REALLOC4CPP_BACKEND_NAME "mimalloc"
+#elif defined(REALLOC4CPP_TCMALLOC)
+#include"tcmalloc_reallocator.h"
+#define REALLOC4CPP_BACKEND tcmalloc_reallocator
+#define REALLOC4CPP_BACKEND_NAME "tcmalloc"
+#elif defined(REALLOC4CPP_GLIBC)
+#include"glibc_reallocator.h"
+#define REALLOC4CPP_BACKEND glibc_reallocator
+#define REALLOC4CPP_BACKEND_NAME "glibc"
+#else
+#include"reallocator.h"
+#define REALLOC4CPP_BACKEND reallocator
+#define REALLOC4CPP_BACKEND_NAME "jemalloc"
+#endif
+
+namespace realloc4cpp {
+
+template<class T, std::size_t Alignment = alignof(T)>
+using backend_reallocator = REALLOC4CPP_BACKEND<T, Alignment>;
+
+inline constexpr const char *backend_name = REALLOC4CPP_BACKEND_NAME;
+
+} // namespace
+
+#undef REALLOC4CPP_BACKEND
+#undef REALLOC4CPP_BACKEND_NAME
+
+#endif // header guard
@@ -0,0 +1,194 @@
+#ifndef __BUMP_REALLOCATOR_H
+#define __BUMP_REALLOCATOR_H
+
+#include"allocator_traits.h"
+#include<cstddef>
+#include<cassert>
+
+namespace realloc4cpp {
+
+//////////////////////////////////////////////////////////////////////////////
+// Monotonic buffer of N bytes (on stack, thread_local or wherever).
+// Only the last allocated block can be freed, expanded or shrunk,
+// the memory of other blocks is reclaimed by reset() or the arena death.
+// Based on Howard Hinnant's arena (https://howardhinnant.github.io/stack_alloc.html)
+template<std::size_t N, std::size_t Alignment = alignof(std::max_align_t)>
+class bump_arena
+{
+    static_assert(N % Alignment == 0,
+        "N must be a multiple of the alignment");
+    alignas(Alignment) char buf_[N];
+    char *ptr_;
+
+    static constexpr std::size_t align_up(std::size_t n) noexcept
+    {
+        return (n + (Alignment - 1)) & ~(Alignment - 1);
+    }
+    bool pointer_in_buffer(const char *p) const noexcept
+    {
+        return buf_ <= p && p <= buf_ + N;
+    }
+    bool is_last(const char *p, std::size_t n) const noexcept
+    {
+        return p + align_up(n) == ptr_;
+    }
+public:
+    static constexpr std::size_t alignment = Alignment;
+    // Bytes really occupied by the block of n bytes
+    static constexpr std::size_t block_size(std::size_t n) noexcept
+    {
+        return align_up(n);
+    }
+
+    bump_arena() noexcept : ptr_(buf_) {}
+    ~bump_arena() { ptr_ = nullptr; }
+    bump_arena(const bump_arena & ) = delete;
+    bump_arena &operator=(const bump_arena & ) = delete;
+
+    // Returns nullptr if there is no room
+    char *allocate(std::size_t n) noexcept
+    {
+        assert(pointer_in_buffer(ptr_) && "bump_allocator has outlived arena");
+        if(std::size_t(buf_ + N - ptr_) < align_up(n)) return nullptr;
+        char *p = ptr_;
+        ptr_ += align_up(n);
+        return p;
+    }
+    void deallocate(char *p, std::size_t n) noexcept
+    {
+        assert(owns(p));
+        if(is_last(p, n)) ptr_ = p;
+    }
+    // Maximum size the block can be resized to in place, 0 if cannot
+    std::size_t room(const char *p, std::size_t n) const noexcept
+    {
+        assert(owns(p));
+        return is_last(p, n) ? buf_ + N - p : 0;
+    }
+    // The block must be the last one and new_n <= room(p, n)
+    void resize_last(char *p, std::size_t new_n) noexcept
+    {
+        assert(new_n <= std::size_t(buf_ + N - p));
+        ptr_ = p + align_up(new_n);
+    }
+
+    bool owns(const void *p) const noexcept
+    {
+        return pointer_in_buffer(static_cast<const char*>(p));
+    }
+    static constexpr std::size_t size() noexcept { return N; }
+    std::size_t used() const noexcept { return ptr_ - buf_; }
+    void reset() noexcept { ptr_ = buf_; }
+};
+//////////////////////////////////////////////////////////////////////////////
+// Allocates from the bump_arena, uses Fallback when it is exhausted.
+// Blocks owned by the arena are resized in place while they are the last
+// ones, other blocks are resized by Fallback if it can.
+template<class T, std::size_t N,
+    class Fallback = std::allocator<T>,
+    std::size_t Alignment = alignof(std::max_align_t)>
+class bump_reallocator
+{
+public:
+    using arena_type = bump_arena<N, Alignment>;
+private:
+    using FA = allocator_traits<Fallback>;
+    arena_type *a_;
+    Fallback fallback_;
+
+    template<class, std::size_t, class, std::size_t>
+    friend class bump_reallocator;
+
+    static char *bytes(T *p) { return reinterpret_cast<char*>(p); }
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using propagate_on_container_copy_assignment = std::false_type;
+    using propagate_on_container_move_assignment = std::false_type;
+    using propagate_on_container_swap = std::false_type;
+    using is_always_equal = std::false_type;
+    template<class U> struct rebind
+    {
+        using other = bump_reallocator<U, N,
+            typename std::allocator_traits<Fallback>::
+                template rebind_alloc<U>,
+            Alignment>;
+    };
+    static_assert(alignof(T) <= Alignment,
+        "Alignment must be at least alignof(T)");
+
+    explicit bump_reallocator(arena_type &a,
+        const Fallback &fallback = Fallback()) noexcept
+    : a_(&a), fallback_(fallback) {}
+    template<class U, class F2>
+    bump_reallocator(const bump_reallocator<U,N,F2,Alignment> &o) noexcept
+    : a_(o.a_), fallback_(o.fallback_) {}
+    bump_reallocator(const bump_reallocator & ) = default;
+    bump_reallocator &operator=(const bump_reallocator & ) = delete;
+
+    [[nodiscard]] T *allocate(size_type n)
+    {
+        if(char *p = a_->allocate(n * sizeof(T)))
+            return reinterpret_cast<T*>(p);
+        return FA::allocate(fallback_, n);
+    }
+    [[nodiscard]] T *allocate_at_least(size_type &n)
+    {
+        if(char *p = a_->allocate(n * sizeof(T)))
+        {
+            // Take the alignment padding too
+            n = arena_type::block_size(n * sizeof(T)) / sizeof(T);
+            return reinterpret_cast<T*>(p);
+        }
+        return FA::allocate_at_least(fallback_, n);
+    }
+    // Exact for the arena blocks only
+    size_type good_size(size_type n) const
+    {
+        return arena_type::block_size(n * sizeof(T)) / sizeof(T);
+    }
+    void deallocate(T *p, size_type n) noexcept
+    {
+        if(a_->owns(p)) a_->deallocate(bytes(p), n * sizeof(T));
+        else FA::deallocate(fallback_, p, n);
+    }
+    [[nodiscard]] bool expand_by(T *p,
+        size_type &size, size_type preferred_n, size_type least_n)
+    {
+        if(!a_->owns(p))
+            return FA::expand_by(fallback_, p, size, preferred_n, least_n);
+        const size_type max_n = a_->room(bytes(p), size * sizeof(T)) / sizeof(T);
+        if(max_n < size + least_n) return false;
+        const size_type new_size = std::min(size + preferred_n, max_n);
+        a_->resize_last(bytes(p), new_size * sizeof(T));
+        size = new_size;
+        return true;
+    }
+    [[nodiscard]] bool shrink_by(T *p, size_type &size, size_type n)
+    {
+        if(!a_->owns(p)) return FA::shrink_by(fallback_, p, size, n);
+        // Not the last one: the tail cannot be reused, let the caller decide
+        if(!a_->room(bytes(p), size * sizeof(T))) return false;
+        a_->resize_last(bytes(p), (size - n) * sizeof(T));
+        size -= n;
+        return true;
+    }
+
+    arena_type &arena() const noexcept { return *a_; }
+
+    template<class U, class F2>
+    bool operator==(const bump_reallocator<U,N,F2,Alignment> &o) const noexcept
+    {
+        return a_ == o.a_;
+    }
+    template<class U, class F2>
+    bool operator!=(const bump_reallocator<U,N,F2,Alignment> &o) const noexcept
+    {
+        return !(*this == o);
+    }
+};
+//////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+#endif // header guard
@@ -0,0 +1,241 @@
+#ifndef __CONCURRENT_APPEND_BUFFER_H
+#define __CONCURRENT_APPEND_BUFFER_H
+
+#include"allocator_traits.h"
+#include"growth_policy.h"
+#include<atomic>
+#include<mutex>
+#include<thread>
+#include<new>
+#include<stdexcept>
+#include<type_traits>
+#include<algorithm>
+#include<cassert>
+
+namespace realloc4cpp {
+
+//////////////////////////////////////////////////////////////////////////////
+// Append-only buffer for many producer threads. A producer takes its slot
+// with one atomic increment and constructs the element there, no lock.
+// The thread whose slot is past the capacity grows the buffer while the
+// others needing more room wait for it:
+// - the last segment is expanded in place (expand_by()), the slots just
+//   become valid, no new address is published,
+// - when it fails, a new segment is started (the size of Growth's
+//   relocate_increment()).
+// Elements are never moved, so the references stay valid.
+//
+// Reading (size(), operator[], for_each_segment()) is only safe after the
+// producers finished (e.g. were joined). After a failed allocation the
+// buffer is full: the producers getting no slot throw std::bad_alloc.
+// Allocator::construct() must be thread-safe (the default one is).
+template<class T, class Allocator = std::allocator<T>,
+    class Growth = doubling_growth, std::size_t MaxSegments = 64>
+class concurrent_append_buffer : private Allocator
+{
+    using A = allocator_traits<Allocator>;
+public:
+    using value_type = T;
+    using allocator_type = Allocator;
+    using size_type = typename A::size_type;
+private:
+    static constexpr std::size_t cache_line = 64;
+    static constexpr unsigned max_spins = 64; // before sleeping on the mutex
+
+    // Written by the growing thread before the capacity is published
+    struct segment
+    {
+        T *data;
+        size_type first; // index of the first element
+        size_type capacity;
+    };
+    alignas(cache_line) std::atomic<size_type> reserved{0}; // slots taken
+    alignas(cache_line) std::atomic<size_type> capacity_{0}; // published
+    std::atomic<size_type> segments_{0};
+    std::atomic<bool> failed{false};
+    segment segments[MaxSegments];
+    std::mutex grow_mutex;
+    Growth growth;
+
+    void grow(size_type i); // until slot i is valid
+    void grow_locked(size_type n);
+    T *slot(size_type i) const
+    {
+        size_type k = segments_.load(std::memory_order_acquire);
+        while(segments[--k].first > i) {}
+        return segments[k].data + (i - segments[k].first);
+    }
+public:
+    concurrent_append_buffer() = default;
+    explicit concurrent_append_buffer(const Allocator &a) : Allocator(a) {}
+    explicit concurrent_append_buffer(size_type initial_capacity,
+        const Allocator &a = Allocator())
+    :
+        Allocator(a)
+    {
+        reserve(initial_capacity);
+    }
+    concurrent_append_buffer(const concurrent_append_buffer & ) = delete;
+    concurrent_append_buffer &operator=(
+        const concurrent_append_buffer & ) = delete;
+    ~concurrent_append_buffer();
+
+    allocator_type get_allocator() const { return *this; }
+
+    // The producers
+    void push_back(const T &v) { emplace_back(v); }
+    void push_back(T &&v) { emplace_back(std::move(v)); }
+    // The construction has to be noexcept: the slot cannot be given back
+    template<class... Args> T &emplace_back(Args &&... args);
+    // Can be called concurrently with the producers
+    void reserve(size_type n);
+    size_type capacity() const
+    {
+        return capacity_.load(std::memory_order_acquire);
+    }
+
+    // The readers, after the producers finished
+    bool empty() const { return size() == 0; }
+    size_type size() const
+    {
+        return std::min(reserved.load(std::memory_order_acquire),
+            capacity());
+    }
+    size_type segment_count() const
+    {
+        return segments_.load(std::memory_order_acquire);
+    }
+    T &operator[](size_type i) { assert(i < size()); return *slot(i); }
+    const T &operator[](size_type i) const
+    {
+        assert(i < size());
+        return *slot(i);
+    }
+    // Calls f(first, last) for the elements of every segment in order
+    template<class F> void for_each_segment(F f);
+    template<class F> void for_each_segment(F f) const;
+};
+//////////////////////////////////////////////////////////////////////////////
+//----------------------------------------------------------------------------
+template<class T, class A, class G, std::size_t M>
+concurrent_append_buffer<T,A,G,M>::~concurrent_append_buffer()
+{
+    for_each_segment([this](T *first, T *last) {
+        for(; first != last; ++first) A::destroy(*this, first);
+    });
+    for(size_type k = 0; k < segment_count(); k++)
+        A::deallocate(*this, segments[k].data, segments[k].capacity);
+}
+//----------------------------------------------------------------------------
+template<class T, class A, class G, std::size_t M>
+template<class... Args>
+T &concurrent_append_buffer<T,A,G,M>::emplace_back(Args &&... args)
+{
+    static_assert(std::is_nothrow_constructible<T, Args&&...>::value,
+        "The element construction must not throw");
+    const size_type i = reserved.fetch_add(1, std::memory_order_relaxed);
+    if(i >= capacity_.load(std::memory_order_acquire)) grow(i);
+    T *p = slot(i);
+    A::construct(*this, p, std::forward<Args>(args)...);
+    return *p;
+}
+//----------------------------------------------------------------------------
+template<class T, class A, class G, std::size_t M>
+void concurrent_append_buffer<T,A,G,M>::grow(size_type i)
+{
+    std::unique_lock<std::mutex> lock(grow_mutex, std::defer_lock);
+    // Usually another thread is already growing: wait a little for it
+    for(unsigned spins = 0; !lock.try_lock(); spins++)
+    {
+        if(capacity_.load(std::memory_order_acquire) > i) return;
+        if(failed.load(std::memory_order_relaxed)) throw std::bad_alloc();
+        if(spins == max_spins)
+        {
+            lock.lock();
+            break;
+        }
+        std::this_thread::yield();
+    }
+    grow_locked(i + 1);
+}
+//----------------------------------------------------------------------------
+template<class T, class A, class G, std::size_t M>
+void concurrent_append_buffer<T,A,G,M>::reserve(size_type n)
+{
+    if(n <= capacity()) return;
+    std::lock_guard<std::mutex> lock(grow_mutex);
+    grow_locked(n);
+}
+//----------------------------------------------------------------------------
+template<class T, class A, class G, std::size_t M>
+void concurrent_append_buffer<T,A,G,M>::grow_locked(size_type n)
+{
+    // Only this thread writes the capacity and the segments
+    for(;;)
+    {
+        const size_type cap = capacity_.load(std::memory_order_relaxed);
+        if(n <= cap) return;
+        if(failed.load(std::memory_order_relaxed)) throw std::bad_alloc();
+        const size_type least = n - cap;
+        const size_type k = segments_.load(std::memory_order_relaxed);
+        if(k)
+        {
+            segment &s = segments[k - 1];
+            size_type size = s.capacity;
+            if(A::expand_by(*this, s.data, size,
+                std::max(growth.expand_increment(cap, least), least), least))
+            {
+                growth.expanded(true);
+                s.capacity = size;
+                capacity_.store(s.first + size, std::memory_order_release);
+                continue;
+            }
+            growth.expanded(false);
+        }
+        try
+        {
+            if(k == M) throw std::length_error(
+                "concurrent_append_buffer: too many segments");
+            size_type size =
+                std::max(growth.relocate_increment(cap, least), least);
+            segments[k].data = A::allocate_at_least(*this, size);
+            segments[k].first = cap;
+            segments[k].capacity = size;
+        }
+        catch(...)
+        {
+            failed.store(true, std::memory_order_relaxed);
+            throw;
+        }
+        segments_.store(k + 1, std::memory_order_release);
+        capacity_.store(cap + segments[k].capacity,
+            std::memory_order_release);
+    }
+}
+//----------------------------------------------------------------------------
+template<class T, class A, class G, std::size_t M>
+template<class F>
+void concurrent_append_buffer<T,A,G,M>::for_each_segment(F f)
+{
+    const size_type n = size();
+    for(size_type k = 0; k < segment_count() && segments[k].first < n; k++)
+    {
+        const segment &s = segments[k];
+        f(s.data, s.data + std::min(s.capacity, n - s.first));
+    }
+}
+//----------------------------------------------------------------------------
+template<class T, class A, class G, std::size_t M>
+template<class F>
+void concurrent_append_buffer<T,A,G,M>::for_each_segment(F f) const
+{
+    const_cast<concurrent_append_buffer &>(*this).for_each_segment(
+        [&f](T *first, T *last) {
+            f(const_cast<const T *>(first), const_cast<const T *>(last));
+        });
+}
+//----------------------------------------------------------------------------
+
+} // namespace
+
+#endif // header guard
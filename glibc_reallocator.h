@@ -0,0 +1,110 @@
+#ifndef __GLIBC_REALLOCATOR_H
+#define __GLIBC_REALLOCATOR_H
+
+#include"allocator_traits.h"
+#include<new>
+#include<cstdlib>
+#include<cstring>
+#include<algorithm>
+#include<cstddef>
+#include<type_traits>
+#include<malloc.h>
+
+namespace realloc4cpp {
+
+//////////////////////////////////////////////////////////////////////////////
+// reallocator for the glibc malloc. glibc cannot resize a block in place
+// without the risk of moving it, so:
+// - expand_by() succeeds only within malloc_usable_size() of the block,
+// - reallocate() (trivially relocatable T only) is realloc(), which grows
+//   the chunk in place when the next one is free, or mremap()s the mmapped
+//   ones; autogrow_array does not count it as copying then. The
+//   over-aligned blocks are always copied: realloc() drops the alignment.
+// Alignment is the minimum one, T can need more (see block_alignment()).
+template<class T, std::size_t Alignment = alignof(T)>
+struct glibc_reallocator
+{
+    using value_type = T;
+    using size_type = std::size_t;
+    using is_always_equal = std::true_type;
+    template<class U> struct rebind
+        { using other = glibc_reallocator<U, Alignment>; };
+
+    static_assert((Alignment & (Alignment - 1)) == 0,
+        "Alignment must be a power of 2");
+
+    glibc_reallocator() = default;
+    template<class U, std::size_t A2>
+    constexpr glibc_reallocator(const glibc_reallocator<U,A2> &) noexcept {}
+
+    [[nodiscard]] T *allocate(size_type n)
+    {
+        void *p = nullptr;
+        if constexpr(over_aligned)
+        {
+            if(::posix_memalign(&p, align, n * sizeof(T))) p = nullptr;
+        }
+        else p = std::malloc(n * sizeof(T));
+        if(!p) throw std::bad_alloc();
+        return static_cast<T*>(p);
+    }
+    [[nodiscard]] T *allocate_at_least(size_type &n)
+    {
+        T *p = allocate(n);
+        n = ::malloc_usable_size(p) / sizeof(T);
+        return p;
+    }
+    void deallocate(T *p, size_type ) { std::free(p); }
+    [[nodiscard]] bool expand_by(T *p,
+        size_type &size, size_type , size_type least_n)
+    {
+        const size_type usable = ::malloc_usable_size(p) / sizeof(T);
+        if(usable < size + least_n) return false;
+        size = usable;
+        return true;
+    }
+    // The first used elements are kept
+    [[nodiscard]] T *reallocate(T *p,
+        size_type &size, size_type n, size_type used)
+    {
+        n = std::max(n, size_type(1)); // realloc(p, 0) frees p
+        if constexpr(over_aligned)
+        {
+            // realloc() does not keep the alignment: p stays valid until
+            // the aligned block is there
+            T *new_p = allocate_at_least(n);
+            std::memcpy(static_cast<void*>(new_p),
+                static_cast<const void*>(p), std::min(used, n) * sizeof(T));
+            std::free(p);
+            size = n;
+            return new_p;
+        }
+        else
+        {
+            void *new_p = std::realloc(p, n * sizeof(T));
+            if(!new_p) throw std::bad_alloc();
+            size = ::malloc_usable_size(new_p) / sizeof(T);
+            return static_cast<T*>(new_p);
+        }
+    }
+    static constexpr std::size_t alignment() { return align; }
+private:
+    static constexpr std::size_t align = block_alignment<T>(Alignment);
+    static constexpr bool over_aligned = align > alignof(std::max_align_t);
+};
+//////////////////////////////////////////////////////////////////////////////
+// free() takes any block
+template<class U, std::size_t A1, class V, std::size_t A2>
+inline bool operator==(glibc_reallocator<U,A1>, glibc_reallocator<V,A2>)
+{
+    return true;
+}
+template<class U, std::size_t A1, class V, std::size_t A2>
+inline bool operator!=(glibc_reallocator<U,A1>, glibc_reallocator<V,A2>)
+{
+    return false;
+}
+
+} // namespace
+
+#endif // header guard
@@ -0,0 +1,134 @@
+#ifndef __GROWTH_POLICY_H
+#define __GROWTH_POLICY_H
+
+#include<cstddef>
+
+namespace realloc4cpp {
+
+//////////////////////////////////////////////////////////////////////////////
+// Growth policies of autogrow_array. All of them provide:
+//
+//   // capacity increment to ask expand_by() for (preferred_n)
+//   size_type expand_increment(size_type capacity, size_type least_n);
+//   // capacity increment when the buffer has to be relocated
+//   size_type relocate_increment(size_type capacity, size_type least_n);
+//   // feedback: the result of expand_by() call
+//   void expanded(bool success);
+//   // capacity decrement to ask shrink_by() for when the size decreased,
+//   // 0 keeps the capacity; the container never relocates to shrink
+//   size_type shrink_decrement(size_type capacity, size_type size);
+//   // feedback: the result of shrink_by() call
+//   void shrunk(bool success);
+//
+// Results less than least_n are rounded up by the container. The members
+// are constexpr for the containers used in constant evaluation (C++20).
+//////////////////////////////////////////////////////////////////////////////
+// The classic: capacity is doubled
+struct doubling_growth
+{
+    template<class Size>
+    constexpr Size expand_increment(Size capacity, Size ) const
+        { return capacity; }
+    template<class Size>
+    constexpr Size relocate_increment(Size capacity, Size ) const
+        { return capacity; }
+    constexpr void expanded(bool ) {}
+    template<class Size>
+    constexpr Size shrink_decrement(Size , Size ) const { return 0; }
+    constexpr void shrunk(bool ) {}
+};
+//////////////////////////////////////////////////////////////////////////////
+// Capacity is multiplied by 1.618
+struct golden_ratio_growth
+{
+    template<class Size>
+    constexpr Size expand_increment(Size capacity, Size ) const
+    {
+        return capacity / 1000 * 618 + capacity % 1000 * 618 / 1000;
+    }
+    template<class Size>
+    constexpr Size relocate_increment(Size capacity, Size least_n) const
+    {
+        return expand_increment(capacity, least_n);
+    }
+    constexpr void expanded(bool ) {}
+    template<class Size>
+    constexpr Size shrink_decrement(Size , Size ) const { return 0; }
+    constexpr void shrunk(bool ) {}
+};
+//////////////////////////////////////////////////////////////////////////////
+// Expands by about one jemalloc size class (there are 4 classes per
+// doubling), doubles on relocation
+struct size_class_growth
+{
+    template<class Size>
+    constexpr Size expand_increment(Size capacity, Size ) const
+    {
+        Size pow2 = 1;
+        while(pow2 <= capacity / 2) pow2 *= 2;
+        return pow2 / 4;
+    }
+    template<class Size>
+    constexpr Size relocate_increment(Size capacity, Size ) const
+        { return capacity; }
+    constexpr void expanded(bool ) {}
+    template<class Size>
+    constexpr Size shrink_decrement(Size , Size ) const { return 0; }
+    constexpr void shrunk(bool ) {}
+};
+//////////////////////////////////////////////////////////////////////////////
+// Asks for small increments while in-place expansion keeps succeeding,
+// gradually returns to doubling when it fails
+class adaptive_growth
+{
+    // Success rate, exponentially weighted, 0..max_rate
+    static constexpr unsigned max_rate = 256;
+    unsigned rate = max_rate * 3 / 4;
+public:
+    template<class Size>
+    constexpr Size expand_increment(Size capacity, Size ) const
+    {
+        if(rate >= max_rate * 3 / 4) return capacity / 4;
+        if(rate >= max_rate / 2) return capacity / 2;
+        return capacity;
+    }
+    template<class Size>
+    constexpr Size relocate_increment(Size capacity, Size ) const
+        { return capacity; }
+    constexpr void expanded(bool success)
+    {
+        if(success) rate += (max_rate - rate) / 8;
+        else rate -= (rate + 7) / 8;
+    }
+    template<class Size>
+    constexpr Size shrink_decrement(Size , Size ) const { return 0; }
+    constexpr void shrunk(bool ) {}
+    constexpr unsigned success_rate() const // %
+        { return rate * 100 / max_rate; }
+};
+//////////////////////////////////////////////////////////////////////////////
+// Adds automatic shrinking to Growth: when the size drops below
+// capacity / Divisor the capacity is halved in place. The gap between
+// the thresholds (grow when full, shrink below 1/Divisor) keeps
+// push/pop sequences amortised O(1). After a failed shrink_by() the same
+// capacity is not tried again.
+template<class Growth = doubling_growth, unsigned Divisor = 4>
+class hysteresis_shrink : public Growth
+{
+    static_assert(Divisor > 2, "Divisor must exceed 2 to avoid thrashing");
+    std::size_t asked = 0, failed = 0; // capacities
+public:
+    template<class Size>
+    constexpr Size shrink_decrement(Size capacity, Size size)
+    {
+        if(size >= capacity / Divisor || capacity == failed) return 0;
+        asked = capacity;
+        return capacity / 2;
+    }
+    constexpr void shrunk(bool success) { if(!success) failed = asked; }
+};
+//////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+#endif // header guard
@@ -0,0 +1,130 @@
+#ifndef __HUGEPAGE_REALLOCATOR_H
+#define __HUGEPAGE_REALLOCATOR_H
+
+#include"reallocator.h"
+#include<algorithm>
+#include<cstdint>
+#include<sys/mman.h>
+#include<unistd.h>
+
+#ifndef MADV_POPULATE_WRITE
+#define MADV_POPULATE_WRITE 23 // Linux 5.14
+#endif
+
+namespace realloc4cpp {
+
+//////////////////////////////////////////////////////////////////////////////
+// reallocator backing large buffers with transparent huge pages:
+// - blocks of HugePage bytes or more are aligned to HugePage, so THP can
+//   map them with huge pages from the first byte,
+// - allocated, expanded and reallocated ranges are madvise(MADV_HUGEPAGE)d,
+// - Populate prefaults them with MADV_POPULATE_WRITE, so the following
+//   push_backs do not page fault.
+// A small (unaligned) block is not expanded past HugePage; it is relocated
+// once to the aligned one instead.
+// Linux only.
+template<class T, bool Populate = false,
+    std::size_t HugePage = std::size_t(2) << 20>
+struct hugepage_reallocator
+{
+    using value_type = T;
+    using size_type = std::size_t;
+    using is_always_equal = std::true_type;
+    template<class U> struct rebind
+        { using other = hugepage_reallocator<U, Populate, HugePage>; };
+
+    static_assert((HugePage & (HugePage - 1)) == 0,
+        "HugePage must be a power of 2");
+
+    hugepage_reallocator() = default;
+    template<class U>
+    constexpr hugepage_reallocator(
+        const hugepage_reallocator<U,Populate,HugePage> &) noexcept {}
+
+    [[nodiscard]] T *allocate(size_type n)
+    {
+        T *p = ops::allocate(n, flags(n));
+        advise(p, 0, n);
+        return p;
+    }
+    [[nodiscard]] T *allocate_at_least(size_type &n)
+    {
+        T *p = ops::allocate_at_least(n, flags(n));
+        advise(p, 0, n);
+        return p;
+    }
+    void deallocate(T *p, size_type n)
+    {
+        ops::deallocate(p, n, flags(n));
+    }
+    size_type good_size(size_type n) const
+    {
+        return ops::good_size(n, flags(n));
+    }
+    [[nodiscard]] bool expand_by(T *p,
+        size_type &size, size_type preferred_n, size_type least_n)
+    {
+        const size_type old_size = size;
+        if(!aligned(p)) // stay below HugePage, it is the time to relocate
+        {
+            const size_type max_n = huge_n() > size ? huge_n() - 1 - size : 0;
+            if(least_n > max_n) return false;
+            preferred_n = std::min(preferred_n, max_n);
+        }
+        if(!ops::expand_by(p, size, preferred_n, least_n, flags(size)))
+            return false;
+        advise(p, old_size, size);
+        return true;
+    }
+    [[nodiscard]] T *reallocate(T *p, size_type &size, size_type n)
+    {
+        T *new_p = ops::reallocate(p, size, n, flags(n));
+        advise(new_p, 0, size);
+        return new_p;
+    }
+    [[nodiscard]] bool shrink_by(T *p, size_type &size, size_type n)
+    {
+        return ops::shrink_by(p, size, n, flags(size - n));
+    }
+private:
+    using ops = mallocx_ops<T>;
+    static constexpr size_type huge_n()
+    {
+        return (HugePage + sizeof(T) - 1) / sizeof(T);
+    }
+    static int flags(size_type n)
+    {
+        return n >= huge_n() ? MALLOCX_ALIGN(HugePage) :
+            MALLOCX_ALIGN(alignof(T));
+    }
+    static bool aligned(const T *p)
+    {
+        return reinterpret_cast<std::uintptr_t>(p) % HugePage == 0;
+    }
+    // Advises the whole pages of elements [from, to) of the large block
+    static void advise(T *p, size_type from, size_type to)
+    {
+        if(to < huge_n() || !aligned(p)) return;
+        static const std::uintptr_t page = ::sysconf(_SC_PAGESIZE);
+        const auto base = reinterpret_cast<std::uintptr_t>(p);
+        const std::uintptr_t first = (base + from * sizeof(T)) & ~(page - 1);
+        const std::uintptr_t last = (base + to * sizeof(T)) & ~(page - 1);
+        if(first >= last) return;
+        void *addr = reinterpret_cast<void *>(first);
+        // Only hints: failures (no THP, old kernel) are ignored
+        (void) ::madvise(addr, last - first, MADV_HUGEPAGE);
+        if constexpr(Populate)
+            (void) ::madvise(addr, last - first, MADV_POPULATE_WRITE);
+    }
+};
+//////////////////////////////////////////////////////////////////////////////
+template<class U, bool P1, std::size_t H1, class V, bool P2, std::size_t H2>
+inline bool operator==(hugepage_reallocator<U,P1,H1>,
+    hugepage_reallocator<V,P2,H2>) { return true; }
+template<class U, bool P1, std::size_t H1, class V, bool P2, std::size_t H2>
+inline bool operator!=(hugepage_reallocator<U,P1,H1>,
+    hugepage_reallocator<V,P2,H2>) { return false; }
+
+} // namespace
+
+#endif // header guard
@@ -0,0 +1,157 @@
+#ifndef __INCREMENTAL_ARRAY_H
+#define __INCREMENTAL_ARRAY_H
+
+#include"raw_buffer.h"
+#include<cstring>
+#include<cassert>
+
+namespace realloc4cpp {
+
+//////////////////////////////////////////////////////////////////////////////
+// vector-like container that never relocates all the elements at once.
+// When the buffer cannot be expanded in place, the new one is allocated and
+// the elements are moved to it by portions of Step elements on every
+// subsequent push_back() (like incremental rehashing of the hash tables).
+// Meanwhile element i is taken from the buffer where it currently lives.
+template<class T, class Allocator = std::allocator<T>, std::size_t Step = 16>
+class incremental_array
+{
+    static_assert(Step > 0);
+public:
+    using value_type = T;
+    using allocator_type = Allocator;
+    using size_type = typename std::allocator_traits<Allocator>::size_type;
+private:
+    using buffer = raw_buffer<T, Allocator>;
+    buffer buf; // current buffer
+    buffer old; // the buffer being drained
+    size_type size_ = 0;
+    // elements [moved, old_size) still live in old
+    size_type moved = 0, old_size = 0;
+
+    T *location(size_type i) const
+    {
+        return (i >= moved && i < old_size ? old : buf).begin() + i;
+    }
+    void step(size_type );
+    void grow();
+public:
+    incremental_array() = default;
+    explicit incremental_array(const Allocator &a) : buf(a), old(a) {}
+    incremental_array(const incremental_array & ) = delete;
+    incremental_array &operator=(const incremental_array & ) = delete;
+    ~incremental_array() { clear(); }
+
+    allocator_type get_allocator() const { return buf.get_allocator(); }
+
+    bool empty() const { return size_ == 0; }
+    size_type size() const { return size_; }
+    size_type max_size() const { return buf.max_capacity(); }
+    size_type capacity() const { return buf.capacity(); }
+    bool relocating() const { return moved < old_size; }
+
+    T &operator[](size_type i) { assert(i < size_); return *location(i); }
+    const T &operator[](size_type i) const
+        { assert(i < size_); return *location(i); }
+    T &back() { return (*this)[size_ - 1]; }
+    const T &back() const { return (*this)[size_ - 1]; }
+
+    void push_back(const T &v) { emplace_back(v); }
+    void push_back(T &&v) { emplace_back(std::move(v)); }
+    template<class... Args> T &emplace_back(Args &&... );
+    void pop_back();
+    void clear();
+    // Completes the pending relocation right now
+    void finish_relocation() { step(old_size - moved); }
+};
+//////////////////////////////////////////////////////////////////////////////
+//----------------------------------------------------------------------------
+// Moves up to n more elements to the current buffer
+template<class T, class A, std::size_t S>
+void incremental_array<T,A,S>::step(size_type n)
+{
+    n = std::min(n, old_size - moved);
+    if constexpr(is_trivially_relocatable_v<T>)
+    {
+        if(n) std::memcpy(static_cast<void*>(buf.begin() + moved),
+            static_cast<const void*>(old.begin() + moved), n * sizeof(T));
+        moved += n;
+    }
+    else
+        for(; n; n--, moved++) // an exception leaves the element in old
+        {
+            buf.construct(buf.begin() + moved, std::move(old.begin()[moved]));
+            old.destroy(old.begin() + moved);
+        }
+    if(!relocating() && old.begin()) // done
+    {
+        buffer(old.get_allocator()).swap(old);
+        moved = old_size = 0;
+    }
+}
+//----------------------------------------------------------------------------
+template<class T, class A, std::size_t S>
+void incremental_array<T,A,S>::grow()
+{
+    finish_relocation(); // is not expected, the new buffer is 2x larger
+    const size_type cap = capacity();
+    const size_type cap_remain = buf.capacity_remain(1);
+    const size_type add_cap = std::min(std::max(cap, size_type(1)), cap_remain);
+    if(buf.expand_by_at_least(add_cap, 1))
+    {
+        // AWESOME!!! Buffer was enlarged!
+        // No need to move existing elements!
+        return;
+    }
+    // Elements will follow the new buffer later
+    buffer new_buf(cap + add_cap, buf.get_allocator());
+    old.swap(buf);
+    buf.swap(new_buf);
+    old_size = size_;
+    moved = 0;
+    step(0); // nothing to move if empty
+}
+//----------------------------------------------------------------------------
+template<class T, class A, std::size_t S>
+template<class... Args>
+T &incremental_array<T,A,S>::emplace_back(Args &&... args)
+{
+    if(size_ == capacity()) grow();
+    T *p = buf.begin() + size_;
+    buf.construct(p, std::forward<Args>(args)...);
+    ++size_;
+    // After the construction: args could refer to the element being moved
+    try
+    {
+        step(S);
+    }
+    catch(...)
+    {
+        // The element is inserted anyway, the next calls retry the moves
+    }
+    return *p;
+}
+//----------------------------------------------------------------------------
+template<class T, class A, std::size_t S>
+void incremental_array<T,A,S>::pop_back()
+{
+    assert(!empty());
+    if(--size_ >= moved && size_ < old_size) // the last one is still in old
+    {
+        old.destroy(old.begin() + size_);
+        old_size = size_;
+        step(0);
+    }
+    else buf.destroy(buf.begin() + size_);
+}
+//----------------------------------------------------------------------------
+template<class T, class A, std::size_t S>
+void incremental_array<T,A,S>::clear()
+{
+    while(!empty()) pop_back();
+}
+//----------------------------------------------------------------------------
+
+} // namespace
+
+#endif // header guard
@@ -0,0 +1,81 @@
+#ifndef __JEMALLOC_MEMORY_RESOURCE_H
+#define __JEMALLOC_MEMORY_RESOURCE_H
+
+#include"resizable_memory_resource.h"
+#include"reallocator.h"
+
+namespace realloc4cpp {
+
+//////////////////////////////////////////////////////////////////////////////
+// resizable_memory_resource calling jemalloc as reallocator does, in some
+// arena (see create_arena()) if given. tcache_flags is 0 (thread cache of
+// the calling thread), MALLOCX_TCACHE_NONE or MALLOCX_TCACHE(tcache_index).
+// Thread-safe. All jemalloc resources can free the blocks of each other.
+class jemalloc_memory_resource : public resizable_memory_resource
+{
+    using ops = mallocx_ops<unsigned char>;
+    int flags_, tcache_;
+
+    int flags(std::size_t alignment) const noexcept
+    {
+        return MALLOCX_ALIGN(alignment) | flags_;
+    }
+    // jemalloc has no blocks of 0 bytes
+    static std::size_t nonzero(std::size_t size) { return size ? size : 1; }
+    static unsigned char *bytes(void *p)
+    {
+        return static_cast<unsigned char*>(p);
+    }
+
+    void *do_allocate(std::size_t size, std::size_t alignment) override
+    {
+        return ops::allocate(nonzero(size), flags(alignment));
+    }
+    void do_deallocate(void *p, std::size_t size,
+        std::size_t alignment) override
+    {
+        ops::deallocate(bytes(p), nonzero(size),
+            MALLOCX_ALIGN(alignment) | tcache_);
+    }
+    bool do_is_equal(
+        const std::pmr::memory_resource &o) const noexcept override
+    {
+        return dynamic_cast<const jemalloc_memory_resource*>(&o);
+    }
+    void *do_allocate_at_least(std::size_t &size,
+        std::size_t alignment) override
+    {
+        size = nonzero(size);
+        return ops::allocate_at_least(size, flags(alignment));
+    }
+    bool do_expand(void *p, std::size_t &size, std::size_t preferred,
+        std::size_t least, std::size_t alignment) override
+    {
+        return ops::expand_by(bytes(p), size, preferred, least,
+            flags(alignment));
+    }
+    bool do_shrink(void *p, std::size_t &size, std::size_t n,
+        std::size_t alignment) override
+    {
+        return ops::shrink_by(bytes(p), size, n, flags(alignment));
+    }
+public:
+    // The automatic arenas
+    jemalloc_memory_resource() noexcept : flags_(0), tcache_(0) {}
+    explicit jemalloc_memory_resource(unsigned arena,
+        int tcache_flags = 0) noexcept
+        : flags_(MALLOCX_ARENA(arena) | tcache_flags), tcache_(tcache_flags)
+    {}
+};
+//----------------------------------------------------------------------------
+// The resource of the automatic arenas, as std::pmr::new_delete_resource()
+inline jemalloc_memory_resource *jemalloc_resource() noexcept
+{
+    static jemalloc_memory_resource r;
+    return &r;
+}
+//////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+#endif // header guard
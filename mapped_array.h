@@ -0,0 +1,187 @@
+#ifndef __MAPPED_ARRAY_H
+#define __MAPPED_ARRAY_H
+
+#include"autogrow_array.h"
+#include"mmap_reallocator.h"
+#include<algorithm>
+#include<cstdint>
+#include<cstring>
+#include<string>
+#include<stdexcept>
+#include<system_error>
+
+namespace realloc4cpp {
+
+//////////////////////////////////////////////////////////////////////////////
+// Persistent autogrow_array: the elements live in the file and are mapped
+// back by the next run without any deserialisation. The first page of the
+// file is the header keeping the size, the elements follow it.
+// The kernel writes the pages back; sync() waits for that. The content is
+// in the layout of this build: T must not contain pointers.
+//
+// Not thread-safe, one object per file.
+template<class T, class Growth = doubling_growth,
+    class Stats = default_realloc_stats>
+class mapped_array : private autogrow_array<T, mmap_reallocator<T>, Growth,
+    serial_relocation, Stats>
+{
+    using base = autogrow_array<T, mmap_reallocator<T>, Growth,
+        serial_relocation, Stats>;
+    struct header
+    {
+        char magic[8];
+        std::uint32_t version, element_size;
+        std::uint64_t size;
+    };
+    static constexpr char signature[8] = {'R','4','C','A','R','R','A','Y'};
+    header *h;
+
+    void store_size() { h->size = base::size(); }
+public:
+    using typename base::value_type;
+    using typename base::size_type;
+    using typename base::difference_type;
+    using typename base::reference;
+    using typename base::const_reference;
+    using typename base::pointer;
+    using typename base::const_pointer;
+    using typename base::iterator;
+    using typename base::const_iterator;
+    using typename base::reverse_iterator;
+    using typename base::const_reverse_iterator;
+
+    // Opens the array or creates the empty one. Throws std::system_error
+    // and std::runtime_error if the file has another format.
+    explicit mapped_array(const char *path, mode_t mode = 0644);
+    mapped_array(const mapped_array & ) = delete;
+    mapped_array &operator=(const mapped_array & ) = delete;
+    ~mapped_array();
+
+    using base::empty;
+    using base::size;
+    using base::max_size;
+    using base::capacity;
+    using base::reserve;
+
+    using base::data;
+    using base::operator[];
+    using base::at;
+    using base::front;
+    using base::back;
+
+    using base::begin;
+    using base::end;
+    using base::cbegin;
+    using base::cend;
+    using base::rbegin;
+    using base::rend;
+
+    // Appending, the size is stored after the elements are written
+    void push_back(const T &v) { emplace_back(v); }
+    template<class... Args>
+    T &emplace_back(Args &&... args)
+    {
+        T &v = base::emplace_back(std::forward<Args>(args)...);
+        store_size();
+        return v;
+    }
+    template<class InputIt>
+    void append(InputIt first, InputIt last)
+    {
+        base::append(first, last);
+        store_size();
+    }
+    void append_n(size_type n, const T &v)
+    {
+        base::append_n(n, v);
+        store_size();
+    }
+    void resize(size_type n) { base::resize(n); store_size(); }
+    void resize(size_type n, const T &v) { base::resize(n, v); store_size(); }
+    void pop_back() { base::pop_back(); store_size(); }
+    void clear() { base::clear(); store_size(); }
+    // Truncates the file to the size, throws std::system_error
+    void shrink_to_fit();
+
+    // Flushes the elements and the size to the disk, throws std::system_error
+    void sync();
+};
+//////////////////////////////////////////////////////////////////////////////
+//----------------------------------------------------------------------------
+template<class T, class G, class S>
+mapped_array<T,G,S>::mapped_array(const char *path, mode_t mode)
+:
+    base(mmap_reallocator<T>(path, mmap_reallocator<T>::page_size(), mode))
+{
+    const int fd = base::get_allocator().fd();
+    const std::size_t page = mmap_reallocator<T>::page_size();
+    struct stat st;
+    if(::fstat(fd, &st)) throw std::system_error(errno,
+        std::system_category(), path);
+    const bool created = st.st_size == 0;
+    if(created && ::ftruncate(fd, off_t(page)))
+        throw std::system_error(errno, std::system_category(), path);
+    if(std::size_t(st.st_size) < sizeof(header) && !created)
+        throw std::runtime_error(std::string(path) + ": not an array");
+    void *p = ::mmap(nullptr, page, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if(p == MAP_FAILED) throw std::system_error(errno,
+        std::system_category(), path);
+    h = static_cast<header*>(p);
+    if(created)
+    {
+        std::memcpy(h->magic, signature, sizeof signature);
+        h->version = 1;
+        h->element_size = sizeof(T);
+        h->size = 0;
+    }
+    const std::size_t capacity = st.st_size > off_t(page) ?
+        (st.st_size - page) / sizeof(T) : 0;
+    if(std::memcmp(h->magic, signature, sizeof signature) ||
+        h->version != 1 || h->element_size != sizeof(T) ||
+        h->size > capacity)
+    {
+        ::munmap(h, page);
+        throw std::runtime_error(std::string(path) + ": not an array of T");
+    }
+    if(!h->size) return;
+    try
+    {
+        base::reserve(size_type(h->size)); // maps the file in place
+    }
+    catch(...)
+    {
+        ::munmap(h, page);
+        throw;
+    }
+    base::adopt(size_type(h->size));
+}
+//----------------------------------------------------------------------------
+template<class T, class G, class S>
+mapped_array<T,G,S>::~mapped_array()
+{
+    ::munmap(h, mmap_reallocator<T>::page_size());
+}
+//----------------------------------------------------------------------------
+template<class T, class G, class S>
+void mapped_array<T,G,S>::shrink_to_fit()
+{
+    base::shrink_to_fit();
+    // The empty array only unmaps the block, keep just the header
+    if(empty() && ::ftruncate(base::get_allocator().fd(),
+        off_t(mmap_reallocator<T>::page_size())))
+        throw std::system_error(errno, std::system_category(), "ftruncate()");
+}
+//----------------------------------------------------------------------------
+template<class T, class G, class S>
+void mapped_array<T,G,S>::sync()
+{
+    if(!empty() && ::msync(data(), size() * sizeof(T), MS_SYNC))
+        throw std::system_error(errno, std::system_category(), "msync()");
+    if(::msync(h, sizeof(header), MS_SYNC))
+        throw std::system_error(errno, std::system_category(), "msync()");
+}
+//----------------------------------------------------------------------------
+
+} // namespace
+
+#endif // header guard
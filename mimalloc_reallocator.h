@@ -0,0 +1,91 @@
+#ifndef __MIMALLOC_REALLOCATOR_H
+#define __MIMALLOC_REALLOCATOR_H
+
+#include"allocator_traits.h"
+#include<new>
+#include<algorithm>
+#include<type_traits>
+#include<mimalloc.h>
+
+namespace realloc4cpp {
+
+//////////////////////////////////////////////////////////////////////////////
+// reallocator for mimalloc. expand_by() is mi_expand(): it succeeds while
+// the block fits into its size class (mi_usable_size()). mimalloc cannot
+// give the memory back in place, so there is no shrink_by().
+// Alignment is the minimum one, T can need more (see block_alignment()).
+template<class T, std::size_t Alignment = alignof(T)>
+struct mimalloc_reallocator
+{
+    using value_type = T;
+    using size_type = std::size_t;
+    using is_always_equal = std::true_type;
+    template<class U> struct rebind
+        { using other = mimalloc_reallocator<U, Alignment>; };
+
+    static_assert((Alignment & (Alignment - 1)) == 0,
+        "Alignment must be a power of 2");
+
+    mimalloc_reallocator() = default;
+    template<class U>
+    constexpr mimalloc_reallocator(
+        const mimalloc_reallocator<U,Alignment> &) noexcept {}
+
+    [[nodiscard]] T *allocate(size_type n)
+    {
+        void *p = ::mi_malloc_aligned(n * sizeof(T), align);
+        if(!p) throw std::bad_alloc();
+        return static_cast<T*>(p);
+    }
+    [[nodiscard]] T *allocate_at_least(size_type &n)
+    {
+        T *p = allocate(n);
+        n = ::mi_usable_size(p) / sizeof(T);
+        return p;
+    }
+    void deallocate(T *p, size_type n)
+    {
+        ::mi_free_size_aligned(p, n * sizeof(T), align);
+    }
+    size_type good_size(size_type n) const
+    {
+        return n ? ::mi_good_size(n * sizeof(T)) / sizeof(T) : 0;
+    }
+    [[nodiscard]] bool expand_by(T *p,
+        size_type &size, size_type preferred_n, size_type least_n)
+    {
+        const size_type old_size = size;
+        if(!::mi_expand(p, (size + std::max(preferred_n, least_n)) *
+            sizeof(T)) && !::mi_expand(p, (size + least_n) * sizeof(T)))
+                return false;
+        size = ::mi_usable_size(p) / sizeof(T);
+        return size > old_size;
+    }
+    [[nodiscard]] T *reallocate(T *p, size_type &size, size_type n)
+    {
+        void *new_p = ::mi_realloc_aligned(p, n * sizeof(T), align);
+        if(!new_p) throw std::bad_alloc();
+        size = ::mi_usable_size(new_p) / sizeof(T);
+        return static_cast<T*>(new_p);
+    }
+    static constexpr std::size_t alignment() { return align; }
+private:
+    static constexpr std::size_t align = block_alignment<T>(Alignment);
+};
+//////////////////////////////////////////////////////////////////////////////
+// Only the allocators with the same Alignment convert to each other: the
+// sized deallocation gets the right alignment
+template<class U, class V, std::size_t A>
+inline bool operator==(mimalloc_reallocator<U,A>, mimalloc_reallocator<V,A>)
+{
+    return true;
+}
+template<class U, class V, std::size_t A>
+inline bool operator!=(mimalloc_reallocator<U,A>, mimalloc_reallocator<V,A>)
+{
+    return false;
+}
+
+} // namespace
+
+#endif // header guard
@@ -0,0 +1,224 @@
+#ifndef __MMAP_REALLOCATOR_H
+#define __MMAP_REALLOCATOR_H
+
+#include<new>
+#include<memory>
+#include<algorithm>
+#include<stdexcept>
+#include<system_error>
+#include<type_traits>
+#include<cerrno>
+#include<cstddef>
+#include<fcntl.h>
+#include<sys/mman.h>
+#include<sys/stat.h>
+#include<unistd.h>
+
+namespace realloc4cpp {
+
+//////////////////////////////////////////////////////////////////////////////
+// Maps the block from a file (MAP_SHARED) starting at offset (a multiple
+// of the page size), the file always ends with the block:
+// - allocate_at_least() (used by the containers) maps the whole existing
+//   content, at least n elements, so the block of the previous run is
+//   found in place,
+// - expand_by() extends the file with ftruncate() and the mapping with
+//   mremap() without MREMAP_MAYMOVE or a mapping next to the block,
+// - shrink_by() unmaps the tail pages and truncates the file,
+// - reallocate() is mremap(MREMAP_MAYMOVE): zero copy,
+// - deallocate() unmaps the block, the file keeps the content.
+// There is one block per file, so T must be trivially copyable: the
+// containers never need the old and the new blocks at once to relocate it.
+// Linux only.
+template<class T>
+class mmap_reallocator
+{
+    static_assert(std::is_trivially_copyable<T>::value,
+        "The file content must be trivially copyable");
+    static_assert(sizeof(T) <= 4096, "T cannot be larger than a page");
+
+    struct file
+    {
+        int fd;
+        off_t offset;
+        explicit file(int fd, off_t offset) : fd(fd), offset(offset) {}
+        file(const file & ) = delete;
+        file &operator=(const file & ) = delete;
+        ~file() { ::close(fd); }
+    };
+    std::shared_ptr<file> f;
+
+    template<class> friend class mmap_reallocator;
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+    // the block always goes together with its file
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+    using is_always_equal = std::false_type;
+    template<class U> struct rebind { using other = mmap_reallocator<U>; };
+
+    // Opens or creates the file, throws std::system_error
+    explicit mmap_reallocator(const char *path, std::size_t offset = 0,
+        mode_t mode = 0644)
+    {
+        if(offset % page_size())
+            throw std::invalid_argument("mmap_reallocator: offset");
+        const int fd = ::open(path, O_RDWR | O_CREAT | O_CLOEXEC, mode);
+        if(fd < 0) throw std::system_error(errno, std::system_category(),
+            path);
+        try
+        {
+            f = std::make_shared<file>(fd, off_t(offset));
+        }
+        catch(...)
+        {
+            ::close(fd);
+            throw;
+        }
+    }
+    template<class U>
+    mmap_reallocator(const mmap_reallocator<U> &o) noexcept : f(o.f) {}
+
+    // Exactly n elements, the rest of the file is truncated
+    [[nodiscard]] T *allocate(size_type n)
+    {
+        return map(std::max(bytes(n), page_size()));
+    }
+    // The whole existing content or n elements if more
+    [[nodiscard]] T *allocate_at_least(size_type &n)
+    {
+        struct stat st;
+        if(::fstat(f->fd, &st)) throw std::bad_alloc();
+        const size_type existing = st.st_size > f->offset ?
+            size_type(st.st_size - f->offset) : 0;
+        const size_type new_bytes =
+            std::max({bytes(n), round(existing), page_size()});
+        T *p = map(new_bytes);
+        n = elements(new_bytes);
+        return p;
+    }
+    void deallocate(T *p, size_type n)
+    {
+        ::munmap(p, bytes(n));
+    }
+    size_type good_size(size_type n) const { return elements(bytes(n)); }
+    [[nodiscard]] bool expand_by(T *p,
+        size_type &size, size_type preferred_n, size_type least_n)
+    {
+        const auto old_bytes = bytes(size);
+        const auto least_bytes = bytes(size + least_n);
+        const auto preferred_bytes = bytes(size + preferred_n);
+        if(least_bytes <= old_bytes) // fits into the tail of the last page
+        {
+            size = elements(old_bytes);
+            return true;
+        }
+        auto new_bytes = preferred_bytes;
+        if(!try_expand(p, old_bytes, new_bytes))
+        {
+            if(least_bytes == preferred_bytes) return false;
+            if(!try_expand(p, old_bytes, new_bytes = least_bytes))
+                return false;
+        }
+        size = elements(new_bytes);
+        return true;
+    }
+    [[nodiscard]] bool shrink_by(T *p, size_type &size, size_type n)
+    {
+        const auto old_bytes = bytes(size);
+        auto new_bytes = bytes(size - n);
+        if(new_bytes == 0) new_bytes = page_size(); // keep the block alive
+        if(new_bytes >= old_bytes) return false; // no whole page to free
+        if(::munmap(reinterpret_cast<char*>(p) + new_bytes,
+            old_bytes - new_bytes)) return false;
+        (void) resize_file(new_bytes); // only the disk space is lost
+        size = elements(new_bytes);
+        return true;
+    }
+    // Can move the block, the content stays in the file
+    [[nodiscard]] T *reallocate(T *p, size_type &size, size_type n)
+    {
+        const auto old_bytes = bytes(size), new_bytes = bytes(n);
+        if(new_bytes > old_bytes && !resize_file(new_bytes))
+            throw std::bad_alloc();
+        void *new_p = ::mremap(p, old_bytes, new_bytes, MREMAP_MAYMOVE);
+        if(new_p == MAP_FAILED)
+        {
+            if(new_bytes > old_bytes) (void) resize_file(old_bytes);
+            throw std::bad_alloc();
+        }
+        if(new_bytes < old_bytes) (void) resize_file(new_bytes);
+        size = elements(new_bytes);
+        return static_cast<T*>(new_p);
+    }
+
+    int fd() const noexcept { return f->fd; }
+    std::size_t offset() const noexcept { return std::size_t(f->offset); }
+    static size_type page_size()
+    {
+        static const size_type size = ::sysconf(_SC_PAGESIZE);
+        return size;
+    }
+
+    template<class U>
+    bool operator==(const mmap_reallocator<U> &o) const noexcept
+    {
+        return f == o.f;
+    }
+    template<class U>
+    bool operator!=(const mmap_reallocator<U> &o) const noexcept
+    {
+        return f != o.f;
+    }
+private:
+    static size_type round(size_type bytes)
+    {
+        const size_type mask = page_size() - 1;
+        return (bytes + mask) & ~mask;
+    }
+    static size_type bytes(size_type n) { return round(n * sizeof(T)); }
+    static size_type elements(size_type bytes) { return bytes / sizeof(T); }
+
+    bool resize_file(size_type bytes) const
+    {
+        return ::ftruncate(f->fd, f->offset + off_t(bytes)) == 0;
+    }
+    T *map(size_type bytes) const
+    {
+        if(!resize_file(bytes)) throw std::bad_alloc();
+        void *p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+            MAP_SHARED, f->fd, f->offset);
+        if(p == MAP_FAILED) throw std::bad_alloc();
+        return static_cast<T*>(p);
+    }
+    bool try_expand(T *p, size_type old_bytes, size_type new_bytes) const
+    {
+        if(!resize_file(new_bytes)) return false;
+        if(::mremap(p, old_bytes, new_bytes, 0) != MAP_FAILED ||
+            map_next(p, old_bytes, new_bytes)) return true;
+        (void) resize_file(old_bytes);
+        return false;
+    }
+    // Try to map the extended part of the file right after the block
+    bool map_next(T *p, size_type old_bytes, size_type new_bytes) const
+    {
+#ifdef MAP_FIXED_NOREPLACE
+        char *tail = reinterpret_cast<char*>(p) + old_bytes;
+        void *q = ::mmap(tail, new_bytes - old_bytes, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_FIXED_NOREPLACE, f->fd, f->offset + old_bytes);
+        if(q == tail) return true;
+        // Pre-4.17 kernels treat the flag as a hint
+        if(q != MAP_FAILED) ::munmap(q, new_bytes - old_bytes);
+#else
+        (void) p; (void) old_bytes; (void) new_bytes;
+#endif
+        return false;
+    }
+};
+//////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+#endif // header guard
@@ -0,0 +1,149 @@
+#ifndef __NUMA_REALLOCATOR_H
+#define __NUMA_REALLOCATOR_H
+
+#include"reallocator.h"
+#include<thread>
+#include<vector>
+#include<cstdint>
+#include<cerrno>
+#include<linux/mempolicy.h>
+#include<sys/syscall.h>
+#include<unistd.h>
+
+namespace realloc4cpp {
+
+//////////////////////////////////////////////////////////////////////////////
+// reallocator placing the memory on NUMA node Node. Blocks come from the
+// arena of the node (see node_arena()) and their pages are bound to it.
+// expand_by() migrates the tail pages that already reside on another node
+// and fails if some cannot be moved: the container relocates then.
+// TouchThreads > 0 makes freshly allocated or grown regions be
+// prefaulted by that many threads.
+// Linux only, no libnuma is required.
+template<class T, unsigned Node, unsigned TouchThreads = 0>
+struct numa_reallocator
+{
+    using value_type = T;
+    using size_type = std::size_t;
+    using is_always_equal = std::true_type;
+    template<class U> struct rebind
+        { using other = numa_reallocator<U, Node, TouchThreads>; };
+
+    static_assert(Node < sizeof(unsigned long) * 8, "Node is too big");
+
+    numa_reallocator() = default;
+    template<class U>
+    constexpr numa_reallocator(
+        const numa_reallocator<U,Node,TouchThreads> &) noexcept {}
+
+    [[nodiscard]] T *allocate(size_type n)
+    {
+        T *p = ops::allocate(n, flags());
+        place(p, 0, n * sizeof(T), MPOL_MF_MOVE);
+        return p;
+    }
+    [[nodiscard]] T *allocate_at_least(size_type &n)
+    {
+        T *p = ops::allocate_at_least(n, flags());
+        place(p, 0, n * sizeof(T), MPOL_MF_MOVE);
+        return p;
+    }
+    // Unsized: a failed expand_by() can leave the block larger than known
+    void deallocate(T *p, size_type )
+    {
+        je_dallocx(p, flags());
+    }
+    size_type good_size(size_type n) const
+    {
+        return ops::good_size(n, flags());
+    }
+    [[nodiscard]] bool expand_by(T *p,
+        size_type &size, size_type preferred_n, size_type least_n)
+    {
+        const size_type old_size = size;
+        if(!ops::expand_by(p, size, preferred_n, least_n, flags()))
+            return false;
+        const std::size_t from = old_size * sizeof(T), to = size * sizeof(T);
+        if(place(p, from, to, MPOL_MF_STRICT) ||
+            place(p, from, to, MPOL_MF_MOVE | MPOL_MF_STRICT)) return true;
+        // Some pages stay on the wrong node: return them if possible, the
+        // block is never reported grown with them
+        size_type sz = size;
+        static_cast<void>(ops::shrink_by(p, sz, size - old_size, flags()));
+        size = old_size;
+        return false;
+    }
+    [[nodiscard]] bool shrink_by(T *p, size_type &size, size_type n)
+    {
+        return ops::shrink_by(p, size, n, flags());
+    }
+
+    static constexpr unsigned node() { return Node; }
+private:
+    using ops = mallocx_ops<T>;
+    static int flags()
+    {
+        static const int f = MALLOCX_ALIGN(alignof(T)) |
+            MALLOCX_ARENA(node_arena(Node));
+        return f;
+    }
+    // Binds the whole pages of [p + from, p + to) to Node.
+    // Returns false only if some pages are known to be on another node.
+    static bool place(T *p, std::size_t from, std::size_t to, unsigned mode)
+    {
+        static const std::uintptr_t page = ::sysconf(_SC_PAGESIZE);
+        const auto base = reinterpret_cast<std::uintptr_t>(p);
+        const std::uintptr_t first = (base + from + page - 1) & ~(page - 1);
+        const std::uintptr_t last = (base + to) & ~(page - 1);
+        if(first >= last) return true; // the block is too small, let it be
+        const unsigned long mask = 1UL << Node;
+        // The kernel takes maxnode - 1 bits of the mask
+        if(::syscall(SYS_mbind, first, last - first, MPOL_BIND,
+            &mask, sizeof mask * 8 + 1, mode)) return errno != EIO;
+        if constexpr(TouchThreads > 0) first_touch(first, last, page);
+        return true;
+    }
+    static void first_touch(std::uintptr_t first, std::uintptr_t last,
+        std::uintptr_t page)
+    {
+        const auto touch = [page](std::uintptr_t from, std::uintptr_t to) {
+            for(; from < to; from += page)
+                *reinterpret_cast<volatile char *>(from) = 0;
+        };
+        const std::uintptr_t pages = (last - first) / page;
+        if(TouchThreads == 1 || pages < TouchThreads * 16)
+            return touch(first, last);
+        std::vector<std::thread> threads;
+        const auto bound = [=](unsigned i) {
+            return first + pages * i / TouchThreads * page;
+        };
+        unsigned i = 1;
+        try
+        {
+            threads.reserve(TouchThreads - 1);
+            for(; i < TouchThreads; i++)
+                threads.emplace_back(touch, bound(i), bound(i + 1));
+        }
+        catch(...) // cannot start a thread, touch the rest here
+        {
+            touch(bound(i), bound(TouchThreads));
+        }
+        touch(bound(0), bound(1));
+        for(auto &t : threads) t.join();
+    }
+};
+//////////////////////////////////////////////////////////////////////////////
+template<class U, unsigned N1, unsigned T1, class V, unsigned N2, unsigned T2>
+inline bool operator==(numa_reallocator<U,N1,T1>, numa_reallocator<V,N2,T2>)
+{
+    return N1 == N2;
+}
+template<class U, unsigned N1, unsigned T1, class V, unsigned N2, unsigned T2>
+inline bool operator!=(numa_reallocator<U,N1,T1>, numa_reallocator<V,N2,T2>)
+{
+    return N1 != N2;
+}
+
+} // namespace
+
+#endif // header guard
@@ -0,0 +1,136 @@
+#ifndef __PAGE_REALLOCATOR_H
+#define __PAGE_REALLOCATOR_H
+
+#include<new>
+#include<type_traits>
+#include<cstddef>
+#include<sys/mman.h>
+#include<unistd.h>
+
+namespace realloc4cpp {
+
+//////////////////////////////////////////////////////////////////////////////
+// Maps every block directly with mmap(). Intended for huge (GiB) buffers:
+// - expand_by() tries mremap() without MREMAP_MAYMOVE, then maps the pages
+//   next to the block,
+// - shrink_by() unmaps the tail pages,
+// - reallocate() ("may move" mode, used by allocator_traits only for
+//   trivially relocatable T) moves the pages with mremap(MREMAP_MAYMOVE)
+//   instead of copying them.
+// Linux only.
+template<class T>
+struct page_reallocator
+{
+    using value_type = T;
+    using size_type = std::size_t;
+    using is_always_equal = std::true_type;
+    template<class U> struct rebind { using other = page_reallocator<U>; };
+
+    static_assert(sizeof(T) <= 4096, "T cannot be larger than a page");
+
+    page_reallocator() = default;
+    template<class U>
+    constexpr page_reallocator(const page_reallocator<U> &) noexcept {}
+
+    [[nodiscard]] T *allocate(size_type n)
+    {
+        void *p = ::mmap(nullptr, bytes(n), PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(p == MAP_FAILED) throw std::bad_alloc();
+        return static_cast<T*>(p);
+    }
+    [[nodiscard]] T *allocate_at_least(size_type &n)
+    {
+        auto *p = allocate(n);
+        n = elements(bytes(n));
+        return p;
+    }
+    void deallocate(T *p, size_type n)
+    {
+        ::munmap(p, bytes(n));
+    }
+    size_type good_size(size_type n) const { return elements(bytes(n)); }
+    [[nodiscard]] bool expand_by(T *p,
+        size_type &size, size_type preferred_n, size_type least_n)
+    {
+        const auto old_bytes = bytes(size);
+        const auto least_bytes = bytes(size + least_n);
+        const auto preferred_bytes = bytes(size + preferred_n);
+        if(least_bytes <= old_bytes) // fits into the tail of the last page
+        {
+            size = elements(old_bytes);
+            return true;
+        }
+        auto new_bytes = preferred_bytes;
+        if(!try_expand(p, old_bytes, new_bytes))
+        {
+            if(least_bytes == preferred_bytes) return false;
+            if(!try_expand(p, old_bytes, new_bytes = least_bytes))
+                return false;
+        }
+        size = elements(new_bytes);
+        return true;
+    }
+    [[nodiscard]] bool shrink_by(T *p, size_type &size, size_type n)
+    {
+        const auto old_bytes = bytes(size);
+        auto new_bytes = bytes(size - n);
+        if(new_bytes == 0) new_bytes = page_size(); // keep the block alive
+        if(new_bytes >= old_bytes) return false; // no whole page to free
+        if(::munmap(reinterpret_cast<char*>(p) + new_bytes,
+            old_bytes - new_bytes)) return false;
+        size = elements(new_bytes);
+        return true;
+    }
+    // Can move the block, the content is preserved by the kernel
+    [[nodiscard]] T *reallocate(T *p, size_type &size, size_type n)
+    {
+        void *new_p = ::mremap(p, bytes(size), bytes(n), MREMAP_MAYMOVE);
+        if(new_p == MAP_FAILED) throw std::bad_alloc();
+        size = elements(bytes(n));
+        return static_cast<T*>(new_p);
+    }
+
+    static size_type page_size()
+    {
+        static const size_type size = ::sysconf(_SC_PAGESIZE);
+        return size;
+    }
+private:
+    static size_type bytes(size_type n)
+    {
+        const size_type mask = page_size() - 1;
+        return (n * sizeof(T) + mask) & ~mask;
+    }
+    static size_type elements(size_type bytes) { return bytes / sizeof(T); }
+
+    static bool try_expand(T *p, size_type old_bytes, size_type new_bytes)
+    {
+        return ::mremap(p, old_bytes, new_bytes, 0) != MAP_FAILED ||
+            map_next(p, old_bytes, new_bytes);
+    }
+    // Try to occupy the address space right after the block
+    static bool map_next(T *p, size_type old_bytes, size_type new_bytes)
+    {
+#ifdef MAP_FIXED_NOREPLACE
+        char *tail = reinterpret_cast<char*>(p) + old_bytes;
+        void *q = ::mmap(tail, new_bytes - old_bytes, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+        if(q == tail) return true;
+        // Pre-4.17 kernels treat the flag as a hint
+        if(q != MAP_FAILED) ::munmap(q, new_bytes - old_bytes);
+#else
+        (void) p; (void) old_bytes; (void) new_bytes;
+#endif
+        return false;
+    }
+};
+//////////////////////////////////////////////////////////////////////////////
+template<class U, class V>
+inline bool operator==(page_reallocator<U>, page_reallocator<V>) { return true; }
+template<class U, class V>
+inline bool operator!=(page_reallocator<U>, page_reallocator<V>) { return false; }
+
+} // namespace
+
+#endif // header guard
@@ -0,0 +1,205 @@
+#ifndef __RAW_BUFFER_H
+#define __RAW_BUFFER_H
+
+#include"allocator_traits.h"
+#include"realloc_stats.h"
+#include<stdexcept>
+#include<utility>
+#include<algorithm>
+#include<cassert>
+
+namespace realloc4cpp {
+
+//////////////////////////////////////////////////////////////////////////////
+// Fixed-size memory buffer, can grow
+template<class T, class Allocator = std::allocator<T>,
+    class Stats = default_realloc_stats>
+class raw_buffer : private Allocator
+{
+    T *begin_, *end_;
+    using A = allocator_traits<Allocator>;
+public:
+    using size_type = typename A::size_type;
+    using stats_policy = Stats;
+
+    constexpr raw_buffer() : begin_(nullptr), end_(begin_) {}
+    REALLOC4CPP_CONSTEXPR20 explicit raw_buffer(const Allocator &a)
+        : Allocator(a), begin_(nullptr), end_(begin_) {}
+    REALLOC4CPP_CONSTEXPR20 explicit raw_buffer(size_type initial_capacity)
+    :
+        begin_(A::allocate_at_least(*this, initial_capacity)),
+        end_(begin_ + initial_capacity)
+    {
+        trace(trace_op::allocate, true, capacity());
+    }
+    REALLOC4CPP_CONSTEXPR20 raw_buffer(size_type initial_capacity,
+        const Allocator &a)
+    :
+        Allocator(a),
+        begin_(A::allocate_at_least(*this, initial_capacity)),
+        end_(begin_ + initial_capacity)
+    {
+        trace(trace_op::allocate, true, capacity());
+    }
+    REALLOC4CPP_CONSTEXPR20 raw_buffer(raw_buffer &&o) noexcept
+        : Allocator(std::move(o.alloc())), begin_(o.begin_), end_(o.end_)
+    {
+        o.end_ = o.begin_ = nullptr;
+    }
+    raw_buffer(const raw_buffer & ) = delete;
+    REALLOC4CPP_CONSTEXPR20 ~raw_buffer()
+    {
+        if(!begin_) return;
+        trace(trace_op::deallocate, true, capacity());
+        A::deallocate(*this, begin_, capacity());
+    }
+
+    REALLOC4CPP_CONSTEXPR20 raw_buffer &operator=(raw_buffer &&o) noexcept
+    {
+        swap(o);
+        return *this;
+    }
+    raw_buffer &operator=(const raw_buffer & ) = delete;
+
+    REALLOC4CPP_CONSTEXPR20 Allocator get_allocator() const { return *this; }
+    REALLOC4CPP_CONSTEXPR20 Allocator &alloc() { return *this; }
+
+    REALLOC4CPP_CONSTEXPR20 auto begin() { return begin_; }
+    REALLOC4CPP_CONSTEXPR20 auto end() { return end_; }
+    REALLOC4CPP_CONSTEXPR20 auto begin() const { return begin_; }
+    REALLOC4CPP_CONSTEXPR20 auto end() const { return end_; }
+
+    // How much the capacity still can be increased, n is required
+    REALLOC4CPP_CONSTEXPR20 size_type capacity_remain(size_type n) const
+    {
+        const size_type cap_remain = max_capacity() - capacity();
+        if(n > cap_remain) throw std::length_error("Exceeded max_size()");
+        return cap_remain;
+    }
+    REALLOC4CPP_CONSTEXPR20 bool expand_by_at_least(
+        size_type preferred_n, size_type least_n)
+    {
+        // nothing to expand, never in place in constant evaluation
+        if(!begin_ || is_constant_evaluated()) return false;
+        const size_type old_capacity = capacity();
+        const bool ok = expand_by_at_least_impl(preferred_n, least_n);
+        trace(trace_op::expand, ok, least_n, old_capacity, preferred_n);
+        return ok;
+    }
+    REALLOC4CPP_CONSTEXPR20 bool shrink_by(size_type n)
+    {
+        if(is_constant_evaluated()) return false;
+        const bool ok = shrink_by_impl(n);
+        trace(trace_op::shrink, ok, n);
+        return ok;
+    }
+
+    // Moves the first used elements to a new block of at least n elements,
+    // for trivially relocatable T only
+    void reallocate(size_type n, size_type used)
+    {
+        size_type capacity = this->capacity();
+        if(!begin_)
+        {
+            begin_ = A::allocate_at_least(*this, capacity = n);
+            end_ = begin_ + capacity;
+            trace(trace_op::allocate, true, capacity);
+            return;
+        }
+        // Taken before: the old block can be freed
+        trace_event e{trace_op::reallocate, true, begin_, nullptr, 0,
+            std::min(used, n) * sizeof(T)};
+        begin_ = A::reallocate(*this, begin_, capacity, n, used);
+        end_ = begin_ + capacity;
+        e.to = begin_;
+        e.capacity = e.n = capacity * sizeof(T);
+        Stats::trace(e);
+    }
+
+    template<class... Args>
+    REALLOC4CPP_CONSTEXPR20 void construct(T *p, Args&&... args)
+    {
+        A::construct(*this, p, std::forward<Args>(args)...);
+    }
+    REALLOC4CPP_CONSTEXPR20 void destroy(T *p) { A::destroy(*this, p); }
+    // Exchanges the blocks only: each allocator has to be able to free
+    // the block of the other one
+    REALLOC4CPP_CONSTEXPR20 void swap_blocks(raw_buffer &o) noexcept
+    {
+        std::swap(begin_, o.begin_);
+        std::swap(end_, o.end_);
+    }
+    REALLOC4CPP_CONSTEXPR20 void swap(raw_buffer &o) noexcept
+    {
+        swap_blocks(o);
+        if constexpr(typename A::propagate_on_container_swap())
+        {
+            using std::swap;
+            swap(alloc(), o.alloc());
+        }
+        else // the behaviour is undefined otherwise
+            assert(typename A::is_always_equal() ||
+                get_allocator() == o.get_allocator());
+    }
+
+    // Capacity of the buffer allocated for n elements
+    REALLOC4CPP_CONSTEXPR20 size_type good_capacity(size_type n) const
+    {
+        return A::good_size(*this, n);
+    }
+    REALLOC4CPP_CONSTEXPR20 size_type max_capacity() const
+        { return ~size_type(0) / sizeof(T); }
+    REALLOC4CPP_CONSTEXPR20 size_type capacity() const
+        { return end_ - begin_; }
+private:
+    bool expand_by_at_least_impl(size_type preferred_n, size_type least_n)
+    {
+        const auto t0 = Stats::start();
+        size_type capacity = this->capacity();
+        // Land exactly on the size class boundaries
+        least_n = A::good_size(*this, capacity + least_n) - capacity;
+        preferred_n = std::max(
+            A::good_size(*this, capacity + preferred_n) - capacity, least_n);
+        if(!A::expand_by(*this, begin_, capacity, preferred_n, least_n))
+        {
+            Stats::expanded(false, 0, t0);
+            return false;
+        }
+        Stats::expanded(true, (capacity - this->capacity()) * sizeof(T), t0);
+        end_ = begin_ + capacity;
+        return true;
+    }
+    bool shrink_by_impl(size_type n)
+    {
+        size_type capacity = this->capacity();
+        // No block of 0 elements is left (xallocx(p, 0) is undefined):
+        // autogrow_array frees the block instead
+        if(n >= capacity) return false;
+        // Pointless if the result is in the same size class
+        const size_type good_size = A::good_size(*this, capacity - n);
+        if(good_size >= capacity) return false;
+        n = capacity - good_size;
+        const auto t0 = Stats::start();
+        if(!A::shrink_by(*this, begin_, capacity, n))
+        {
+            Stats::shrunk(false, 0, t0);
+            return false;
+        }
+        Stats::shrunk(true, (this->capacity() - capacity) * sizeof(T), t0);
+        end_ = begin_ + capacity;
+        return true;
+    }
+    REALLOC4CPP_CONSTEXPR20 void trace(trace_op op, bool ok,
+        size_type n, size_type m = 0, size_type preferred = 0) const
+    {
+        const size_type cap = op == trace_op::deallocate ? 0 : capacity();
+        if(!is_constant_evaluated()) Stats::trace(
+            {op, ok, begin_, nullptr, n * sizeof(T), m * sizeof(T),
+                preferred * sizeof(T), cap * sizeof(T)});
+    }
+};
+//////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+#endif // header guard
@@ -1,265 +1,238 @@
-#include"reallocator.h"
-#include"allocator_traits.h"
-#include<stdexcept>
-#include<utility>
-#include<iterator>
-#include<algorithm>
-#include<cassert>
-
-namespace realloc4cpp {
-
-unsigned long realloc_attempts = 0, successful_reallocs = 0;
+#include"backend_reallocator.h"
+#include"autogrow_array.h"
+#include<string>
+#include<vector>
+#include<cstring>
+#include<cstdlib>
+#include<iostream>
+#include<iomanip>
+#include<sched.h>
 
 //////////////////////////////////////////////////////////////////////////////
-// Fixed-size memory buffer, can grow
-template<class T, class Allocator = std::allocator<T>>
-class raw_buffer : private Allocator
-{
-    T *begin_, *end_;
-    using A = allocator_traits<Allocator>;
-public:
-    using size_type = typename A::size_type;
-
-    constexpr raw_buffer() : begin_(nullptr), end_(begin_) {}
-    explicit raw_buffer(size_type initial_capacity)
-    :
-        begin_(A::allocate_at_least(*this, initial_capacity)),
-        end_(begin_ + initial_capacity)
-    {
-    }
-    raw_buffer(raw_buffer &&o) noexcept : begin_(o.begin_), end_(o.end_)
-    {
-        o.end_ = o.begin_ = nullptr;
-    }
-    raw_buffer(const raw_buffer & ) = delete;
-    ~raw_buffer()
-    {
-        if(begin_) A::deallocate(*this, begin_, capacity());
-    }
-
-    raw_buffer &operator=(raw_buffer &&o) noexcept { swap(o); }
-    raw_buffer &operator=(const raw_buffer & ) = delete;
-
-    Allocator get_allocator() const { return *this; }
-
-    auto begin() { return begin_; }
-    auto end() { return end_; }
-    auto begin() const { return begin_; }
-    auto end() const { return end_; }
+// Benchmark suite: compares autogrow_array with std::allocator
+// and backend_reallocator in one run.
+//
+// Usage: realloc4cpp [-r reps] [-c cpu] [-m max_capacity_bytes]
+//
+// Build with -O3, link jemalloc statically. All timings are in CPU clocks.
+// To compare the in-place success rates of the allocators build it once per
+// backend (-DREALLOC4CPP_MIMALLOC etc., see backend_reallocator.h).
+//////////////////////////////////////////////////////////////////////////////
 
-    size_type additional_capacity(size_type n) const
-    {
-        size_type cap = capacity();
-        const size_type cap_remain = max_capacity() - cap;
-        if(n > cap_remain) throw std::length_error("Exceeded max_size()");
-        return std::min(cap, cap_remain);
-    }
-    bool expand_by_at_least(size_type preferred_n, size_type least_n)
-    {
-        realloc_attempts++;
-        size_type capacity = this->capacity();
-        if(!A::expand_by(*this, begin_,
-            capacity, preferred_n, least_n)) return false;
-        end_ = begin_ + capacity;
-        successful_reallocs++;
-        return true;
-    }
-    bool shrink_by(size_type n)
-    {
-        realloc_attempts++;
-        size_type capacity = this->capacity();
-        if(!A::shrink_by(*this, begin_, capacity, n)) return false;
-        end_ = begin_ + capacity;
-        successful_reallocs++;
-        return true;
-    }
+// Serialised time stamp: nothing crosses the measurement boundaries
+inline unsigned long long rdtsc()
+{
+    unsigned aux;
+    __builtin_ia32_lfence();
+    const auto t = __builtin_ia32_rdtscp(&aux);
+    __builtin_ia32_lfence();
+    return t;
+}
 
-    template<class... Args>
-    void construct(T *p, Args&&... args)
-    {
-        A::construct(*this, p, std::forward<Args>(args)...);
-    }
-    void destroy(T *p) { A::destroy(*this, p); }
-    void swap(raw_buffer &o) noexcept
-    {
-        std::swap(begin_, o.begin_);
-        std::swap(end_, o.end_);
-        static_assert(typename A::is_always_equal(),
-            "Add swap for the allocator here!");
-    }
+namespace {
 
-    size_type max_capacity() const { return ~size_type(0) / sizeof(T); }
-    size_type capacity() const { return end_ - begin_; }
-};
 //////////////////////////////////////////////////////////////////////////////
-// vector-like container
-template<class T, class Allocator = std::allocator<T>>
-class autogrow_array
-{
-    raw_buffer<T, Allocator> buf;
-    T *next = buf.begin();
-public:
-    using value_type = T;
-    using allocator_type = Allocator;
-    using size_type = typename std::allocator_traits<Allocator>::size_type;
+// Element types
+struct pod64 { char data[64]; };
+static_assert(sizeof(pod64) == 64);
 
-    constexpr autogrow_array() = default;
-    explicit autogrow_array(size_type );
-    autogrow_array(const autogrow_array & ) = delete;
-    autogrow_array &operator=(const autogrow_array & ) = delete;
-    ~autogrow_array();
+struct throwing_move
+{
+    long v;
+    throwing_move(long v = 0) : v(v) {}
+    throwing_move(throwing_move &&o) noexcept(false) : v(o.v) {}
+    throwing_move(const throwing_move & ) = default;
+    throwing_move &operator=(const throwing_move & ) = default;
+};
 
-    allocator_type get_allocator() const { return buf.get_allocator(); }
+template<class T> T make_value(long i) { return T(i); }
+template<> pod64 make_value<pod64>(long i)
+{
+    pod64 v;
+    std::memset(v.data, int(i), sizeof v.data);
+    return v;
+}
+template<> std::string make_value<std::string>(long i)
+{
+    return std::to_string(i);
+}
 
-    bool empty() const { return next == buf.begin(); }
-    size_type size() const { return next - buf.begin(); }
-    size_type max_size() const { return buf.max_capacity(); }
-    size_type capacity() const { return buf.capacity(); }
+template<class T> struct type_name;
+template<> struct type_name<int>
+    { static constexpr const char *value = "int"; };
+template<> struct type_name<std::string>
+    { static constexpr const char *value = "std::string"; };
+template<> struct type_name<pod64>
+    { static constexpr const char *value = "pod64"; };
+template<> struct type_name<throwing_move>
+    { static constexpr const char *value = "throwing_move"; };
+//////////////////////////////////////////////////////////////////////////////
+using stats = realloc4cpp::realloc_stats<struct bench_tag>;
+template<class T, class Alloc>
+using array = realloc4cpp::autogrow_array<T, Alloc,
+    realloc4cpp::doubling_growth, realloc4cpp::serial_relocation, stats>;
 
-    void push_back(T );
-    void pop_back();
-    void clear();
-    void shrink_to_fit();
+struct summary
+{
+    unsigned long long median, p90, p99, min, max;
+    realloc4cpp::realloc_counters counters;
 };
-//////////////////////////////////////////////////////////////////////////////
 //----------------------------------------------------------------------------
-template<class T, class A>
-autogrow_array<T,A>::autogrow_array(size_type initial_size)
-:
-    buf(initial_size),
-    next(std::uninitialized_fill_n(buf.begin(), initial_size, T{}))
+summary summarize(std::vector<unsigned long long> &t,
+    const realloc4cpp::realloc_counters &counters)
+{
+    std::sort(t.begin(), t.end());
+    auto pct = [&t](unsigned p) { return t[(t.size() - 1) * p / 100]; };
+    return { pct(50), pct(90), pct(99), t.front(), t.back(), counters };
+}
+//////////////////////////////////////////////////////////////////////////////
+// Operation mixes. Each one gets a freshly filled container with
+// size() == capacity() and returns the clocks spent.
+enum class op { push_back, storm, shrink_to_fit, cycle };
+
+const char *op_name(op o)
 {
+    switch(o)
+    {
+        case op::push_back: return "push_back";
+        case op::storm: return "push_back_storm";
+        case op::shrink_to_fit: return "shrink_to_fit";
+        case op::cycle: return "grow_shrink_cycle";
+    }
+    return "?";
 }
 //----------------------------------------------------------------------------
-template<class T, class A>
-autogrow_array<T,A>::~autogrow_array()
+template<class T, class Alloc>
+unsigned long long run_op(op o, array<T,Alloc> &arr)
 {
-    clear();
+    const long n = long(arr.size());
+    unsigned long long t1 = 0, t2 = 0;
+    switch(o)
+    {
+        case op::push_back: // single push_back when size() == capacity()
+            t1 = rdtsc();
+            arr.push_back(make_value<T>(n));
+            t2 = rdtsc();
+            break;
+        case op::storm: // double the size one element at a time
+            t1 = rdtsc();
+            for(long i = 0; i < n; i++) arr.push_back(make_value<T>(i));
+            t2 = rdtsc();
+            break;
+        case op::shrink_to_fit:
+            arr.push_back(make_value<T>(n));
+            arr.pop_back();
+            t1 = rdtsc();
+            arr.shrink_to_fit();
+            t2 = rdtsc();
+            break;
+        case op::cycle: // grow by one, drop back and trim several times
+            t1 = rdtsc();
+            for(int i = 0; i < 8; i++)
+            {
+                arr.push_back(make_value<T>(i));
+                arr.pop_back();
+                arr.shrink_to_fit();
+            }
+            t2 = rdtsc();
+            break;
+    }
+    return t2 - t1;
 }
 //----------------------------------------------------------------------------
-template<class T, class A>
-void autogrow_array<T,A>::pop_back()
+template<class T, class Alloc>
+summary measure(op o, std::size_t n, unsigned reps)
 {
-    assert(!empty());
-    buf.destroy(next);
-    --next;
+    std::vector<unsigned long long> times;
+    times.reserve(reps);
+    realloc4cpp::realloc_counters counters;
+    for(unsigned r = 0; r < reps; r++)
+    {
+        array<T,Alloc> arr(n);
+        // Fill up to the real capacity so the next push_back has to grow
+        while(arr.size() < arr.capacity())
+            arr.push_back(make_value<T>(long(arr.size())));
+        const auto before = stats::snapshot();
+        times.push_back(run_op(o, arr));
+        counters += stats::snapshot() - before;
+    }
+    return summarize(times, counters);
 }
 //----------------------------------------------------------------------------
-template<class T, class A>
-void autogrow_array<T,A>::clear()
+void print(const char *alloc, const summary &s)
 {
-    while(!empty()) pop_back();
+    std::cout << "  " << std::left << std::setw(16) << alloc << std::right <<
+        " median " << std::setw(12) << s.median <<
+        " p90 " << std::setw(12) << s.p90 <<
+        " p99 " << std::setw(12) << s.p99 <<
+        " min " << std::setw(12) << s.min <<
+        " max " << std::setw(12) << s.max <<
+        "  in-place " << s.counters.successes << '/' << s.counters.attempts <<
+        ", relocated " << s.counters.bytes_copied << " bytes\n";
 }
 //----------------------------------------------------------------------------
-template<class T, class A>
-void autogrow_array<T,A>::push_back(T v)
+template<class T>
+void bench_type(unsigned reps, std::size_t max_bytes)
 {
-    if(next == buf.end()) // increase capacity first
+    // Chunks <16KiB are allocated using slabs and cannot be resized
+    // (http://jemalloc.net/jemalloc.3.html) so sweep from below that bound
+    for(std::size_t bytes = std::size_t(4) << 10; bytes <= max_bytes;
+        bytes <<= 2)
     {
-        auto add_cap = buf.additional_capacity(1);
-        if(buf.expand_by_at_least(add_cap, 1))
+        const std::size_t n = std::max<std::size_t>(bytes / sizeof(T), 1);
+        for(op o : {op::push_back, op::storm, op::shrink_to_fit, op::cycle})
         {
-            // AWESOME!!! Buffer was enlarged!
-            // No need to move existing elements!
-        }
-        else // cannot extend, move the buffer as usual
-        {
-            raw_buffer<T,A> new_buf(size() + add_cap);
-            // Using move even if move-ctr of T can throw for short
-            next = std::uninitialized_copy(
-                std::make_move_iterator(buf.begin()),
-                std::make_move_iterator(next),
-                new_buf.begin()
-            );
-            buf.swap(new_buf);
+            std::cout << type_name<T>::value << ", " << (bytes >> 10) <<
+                " KiB (" << n << " elements), " << op_name(o) << '\n';
+            const auto s = measure<T, std::allocator<T>>(o, n, reps);
+            const auto r =
+                measure<T, realloc4cpp::backend_reallocator<T>>(o, n, reps);
+            print("std::allocator", s);
+            print(realloc4cpp::backend_name, r);
+            std::cout << "  gain " << std::fixed << std::setprecision(2) <<
+                double(s.median) / double(std::max(r.median, 1ULL)) << '\n';
         }
     }
-    buf.construct(next, std::move(v));
-    ++next;
 }
 //----------------------------------------------------------------------------
-template<class T, class A>
-void autogrow_array<T,A>::shrink_to_fit()
+void pin_to_cpu(int cpu)
 {
-    if(size() == capacity()) return;
-    if(buf.shrink_by(capacity() - size()))
-    {
-        // AWESOME!!! Buffer was narrowed!
-        // No need to move existing elements!
-    }
-    else // allocate new buffer
-    {
-        raw_buffer<T,A> new_buf(size());
-        // Using move even if move-ctr of T can throw for short
-        next = std::uninitialized_copy(
-            std::make_move_iterator(buf.begin()),
-            std::make_move_iterator(next),
-            new_buf.begin()
-        );
-        buf.swap(new_buf);
-    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if(sched_setaffinity(0, sizeof set, &set))
+        std::cerr << "Cannot pin the thread to CPU " << cpu << '\n';
 }
-//----------------------------------------------------------------------------
+//////////////////////////////////////////////////////////////////////////////
 
 } // namespace
 
-#include<iostream>
-
-inline unsigned long long rdtsc()
-{
-    unsigned aux;
-    return __builtin_ia32_rdtscp(&aux);
-}
-
-int main()
+int main(int argc, char *argv[])
 {
-    using namespace realloc4cpp;
-    // Chunks <16KiB are allocated using slabs and cannot be resized so we
-    // start with this minimal size (http://jemalloc.net/jemalloc.3.html)
-    autogrow_array<int
-#if 1
-        , reallocator<int>
-#endif
-    > arr((size_t(16) << 10) / sizeof(int));
-    std::cout << "capacity = " << arr.capacity() << ", size = " << arr.size() << '\n';
-
-    std::cout << "Add element\n";
-    auto t1 = rdtsc();
-    arr.push_back(1);
-    auto t2 = rdtsc();
-    std::cout << "capacity = " << arr.capacity() << ", size = " << arr.size() << ", time: " << (t2 - t1) << '\n';
-
-    std::cout << "Add element\n";
-    t1 = rdtsc();
-    arr.push_back(2);
-    t2 = rdtsc();
-    std::cout << "capacity = " << arr.capacity() << ", size = " << arr.size() << ", time: " << (t2 - t1) << '\n';
-
-    std::cout << "Add element\n";
-    t1 = rdtsc();
-    arr.push_back(3);
-    t2 = rdtsc();
-    std::cout << "capacity = " << arr.capacity() << ", size = " << arr.size() << ", time: " << (t2 - t1) << '\n';
-
-    std::cout << "Add element\n";
-    t1 = rdtsc();
-    arr.push_back(4);
-    t2 = rdtsc();
-    std::cout << "capacity = " << arr.capacity() << ", size = " << arr.size() << ", time: " << (t2 - t1) << '\n';
-
-    std::cout << "Remove element\n";
-    t1 = rdtsc();
-    arr.pop_back();
-    t2 = rdtsc();
-    std::cout << "capacity = " << arr.capacity() << ", size = " << arr.size() << ", time: " << (t2 - t1) << '\n';
-
-    std::cout << "Shrink ot fit\n";
-    //for(int i = 3; i--;) arr.pop_back();
-    t1 = rdtsc();
-    arr.shrink_to_fit();
-    t2 = rdtsc();
-    std::cout << "capacity = " << arr.capacity() << ", size = " << arr.size() << ", time: " << (t2 - t1) << '\n';
-
-    std::cout << successful_reallocs << " of " << realloc_attempts <<
-        " successful reallocations\n";
+    unsigned reps = 101;
+    int cpu = sched_getcpu();
+    std::size_t max_bytes = std::size_t(64) << 20;
+    for(int i = 1; i + 1 < argc; i += 2)
+    {
+        if(!std::strcmp(argv[i], "-r")) reps = unsigned(std::atoi(argv[i+1]));
+        else if(!std::strcmp(argv[i], "-c")) cpu = std::atoi(argv[i+1]);
+        else if(!std::strcmp(argv[i], "-m"))
+            max_bytes = std::strtoull(argv[i+1], nullptr, 0);
+        else
+        {
+            std::cerr << "Usage: " << argv[0] <<
+                " [-r reps] [-c cpu] [-m max_capacity_bytes]\n";
+            return 1;
+        }
+    }
+    if(reps == 0) reps = 1;
+    pin_to_cpu(cpu);
+    std::cout << "backend = " << realloc4cpp::backend_name <<
+        ", reps = " << reps << ", cpu = " << cpu <<
+        ", max capacity = " << max_bytes << " bytes\n";
+
+    bench_type<int>(reps, max_bytes);
+    bench_type<std::string>(reps, max_bytes);
+    bench_type<pod64>(reps, max_bytes);
+    bench_type<throwing_move>(reps, max_bytes);
 }
@@ -0,0 +1,70 @@
+#include"realloc_replay.h"
+#include"backend_reallocator.h"
+#include<iostream>
+#include<iomanip>
+
+//////////////////////////////////////////////////////////////////////////////
+// Replays an allocation trace against the allocator/growth policy
+// combinations below and reports the in-place hit rate, the bytes copied
+// and the peak RSS of each.
+//
+// Usage: realloc_replay trace_file
+//
+// Record the trace with realloc_trace as the statistics policy of the
+// containers (or build with -DREALLOC4CPP_TRACE) and trace_writer.
+// Pick the backend as for the benchmark (see backend_reallocator.h).
+//////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+using records = std::vector<realloc4cpp::trace_record>;
+using backend = realloc4cpp::backend_reallocator<unsigned char>;
+
+//----------------------------------------------------------------------------
+template<class Allocator, class Growth>
+void run(const char *alloc, const char *growth, const records &trace)
+{
+    const auto r = realloc4cpp::replay<Allocator, Growth>(trace);
+    const double hits = r.attempts ?
+        100.0 * double(r.successes) / double(r.attempts) : 0.0;
+    std::cout << std::left << std::setw(16) << alloc <<
+        std::setw(22) << growth << std::right <<
+        " in-place " << r.successes << '/' << r.attempts <<
+        " (" << std::fixed << std::setprecision(1) << hits << "%)" <<
+        " relocated " << r.relocations << " times, " <<
+        r.bytes_copied << " bytes" <<
+        " peak RSS " << (r.peak_rss >> 10) << " KiB" <<
+        " cycles " << r.cycles << '\n';
+}
+//////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    using namespace realloc4cpp;
+    if(argc != 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " trace_file\n";
+        return 1;
+    }
+    records trace;
+    try
+    {
+        trace = load_trace(argv[1]);
+    }
+    catch(const std::exception &e)
+    {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+    std::cout << trace.size() << " records, backend = " << backend_name <<
+        '\n';
+
+    using std_alloc = std::allocator<unsigned char>;
+    run<std_alloc, doubling_growth>("std::allocator", "doubling", trace);
+    run<backend, doubling_growth>(backend_name, "doubling", trace);
+    run<backend, golden_ratio_growth>(backend_name, "golden_ratio", trace);
+    run<backend, size_class_growth>(backend_name, "size_class", trace);
+    run<backend, adaptive_growth>(backend_name, "adaptive", trace);
+}
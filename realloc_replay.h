@@ -0,0 +1,283 @@
+#ifndef __REALLOC_REPLAY_H
+#define __REALLOC_REPLAY_H
+
+#include"realloc_trace.h"
+#include"raw_buffer.h"
+#include"growth_policy.h"
+#include<unordered_map>
+#include<algorithm>
+#include<stdexcept>
+#include<string>
+#include<cstring>
+#include<cstdio>
+
+namespace realloc4cpp {
+
+//////////////////////////////////////////////////////////////////////////////
+// Reads the file written by trace_writer
+inline std::vector<trace_record> load_trace(const char *path)
+{
+    std::FILE *f = std::fopen(path, "rb");
+    if(!f) throw std::system_error(errno, std::system_category(), path);
+    trace_file_header h;
+    std::vector<trace_record> records;
+    const bool ok = std::fread(&h, sizeof h, 1, f) == 1 &&
+        std::equal(std::begin(h.signature), std::end(h.signature), h.magic) &&
+        h.version == trace_file_header::current_version &&
+        h.record_size == sizeof(trace_record);
+    if(ok)
+    {
+        trace_record r;
+        while(std::fread(&r, sizeof r, 1, f) == 1) records.push_back(r);
+    }
+    std::fclose(f);
+    if(!ok) throw std::runtime_error(std::string(path) + ": not a trace");
+    return records;
+}
+//////////////////////////////////////////////////////////////////////////////
+struct replay_report
+{
+    unsigned long long attempts = 0, successes = 0; // in place
+    unsigned long long relocations = 0, bytes_copied = 0;
+    unsigned long long peak_rss = 0; // bytes, VmHWM, 0 if unknown
+    unsigned long long cycles = 0;
+};
+//----------------------------------------------------------------------------
+namespace replay_detail {
+
+// Resets VmHWM of the process (Linux 4.0+)
+inline void reset_peak_rss()
+{
+    if(std::FILE *f = std::fopen("/proc/self/clear_refs", "w"))
+    {
+        std::fputs("5", f);
+        std::fclose(f);
+    }
+}
+//----------------------------------------------------------------------------
+inline unsigned long long peak_rss()
+{
+    unsigned long long kib = 0;
+    if(std::FILE *f = std::fopen("/proc/self/status", "r"))
+    {
+        char line[128];
+        while(std::fgets(line, sizeof line, f))
+            if(std::sscanf(line, "VmHWM: %llu kB", &kib) == 1) break;
+        std::fclose(f);
+    }
+    return kib << 10;
+}
+//----------------------------------------------------------------------------
+// Marks the deallocation of the old block and the allocation of the new
+// one made by each relocation, or its realloc(): the replayer relocates
+// by itself
+inline std::vector<bool> relocation_internals(
+    const std::vector<trace_record> &records)
+{
+    std::vector<bool> internal(records.size());
+    struct thread_state
+    {
+        std::unordered_map<std::uint64_t, std::size_t> allocated;
+        std::size_t last_free = ~std::size_t(0);
+        std::size_t last_reallocate = ~std::size_t(0);
+    };
+    std::unordered_map<std::uint32_t, thread_state> threads;
+    for(std::size_t i = 0; i < records.size(); i++)
+    {
+        const trace_record &r = records[i];
+        thread_state &t = threads[r.thread];
+        switch(trace_op(r.op))
+        {
+            case trace_op::allocate:
+                t.allocated[r.block] = i;
+                break;
+            case trace_op::deallocate:
+                t.allocated.erase(r.block);
+                t.last_free = i;
+                break;
+            case trace_op::reallocate:
+                t.last_reallocate = i;
+                break;
+            case trace_op::relocate:
+                if(t.last_reallocate != ~std::size_t(0) &&
+                    records[t.last_reallocate].block == r.block)
+                        internal[t.last_reallocate] = true;
+                if(r.block == r.to) break; // realloc()ed in place
+                if(auto it = t.allocated.find(r.to); it != t.allocated.end())
+                {
+                    internal[it->second] = true;
+                    t.allocated.erase(it);
+                }
+                if(t.last_free != ~std::size_t(0) &&
+                    records[t.last_free].block == r.block)
+                        internal[t.last_free] = true;
+                break;
+            default:
+                break;
+        }
+    }
+    return internal;
+}
+
+} // namespace replay_detail
+//////////////////////////////////////////////////////////////////////////////
+// Replays the trace (all the threads in the time stamp order) with
+// Allocator rebound to bytes. When a traced buffer grows past the replayed
+// capacity, the replayed buffer is expanded with the requests of Growth
+// or relocated to the capacity Growth asks for. Relocations of the trace
+// not caused by a failed expansion (reserve(), shrink_to_fit()) are
+// repeated as is, and so are the realloc()s of the buffers outside of a
+// relocation. The trace holds the requests and the capacities but not the
+// element counts, so Growth making smaller steps than the traced policy is
+// replayed as growing at the traced points only.
+// Every byte obtained is written, so peak_rss is the upper bound.
+template<class Allocator = std::allocator<unsigned char>,
+    class Growth = doubling_growth>
+replay_report replay(std::vector<trace_record> records,
+    const Allocator &alloc = Allocator())
+{
+    using byte_allocator = typename
+        std::allocator_traits<Allocator>::template rebind_alloc<unsigned char>;
+    using buffer = raw_buffer<unsigned char, byte_allocator, no_realloc_stats>;
+    enum class pending { none, rename, relocate };
+    struct entry
+    {
+        buffer buf;
+        pending next = pending::none; // for the relocation of the trace
+        std::size_t least = 0; // of the failed expansion
+    };
+
+    std::stable_sort(records.begin(), records.end(),
+        [](const trace_record &a, const trace_record &b) {
+            return a.tsc < b.tsc;
+        });
+    const auto internal = replay_detail::relocation_internals(records);
+    const byte_allocator a(alloc);
+    Growth growth;
+    replay_report report;
+    std::unordered_map<std::uint64_t, entry> buffers;
+
+    const auto touch = [](buffer &b, std::size_t from) {
+        std::memset(b.begin() + from, 0, b.capacity() - from);
+    };
+    const auto rename = [&](auto it, std::uint64_t to) {
+        auto node = buffers.extract(it);
+        node.key() = to;
+        buffers.insert(std::move(node));
+    };
+    const auto relocate = [&](entry &e, std::size_t n, std::size_t bytes) {
+        buffer new_buf(n, a);
+        bytes = std::min({bytes, e.buf.capacity(), new_buf.capacity()});
+        std::memcpy(new_buf.begin(), e.buf.begin(), bytes);
+        touch(new_buf, bytes);
+        e.buf.swap(new_buf);
+        report.relocations++;
+        report.bytes_copied += bytes;
+    };
+
+    replay_detail::reset_peak_rss();
+    const auto t0 = cycle_counter();
+    for(std::size_t i = 0; i < records.size(); i++)
+    {
+        if(internal[i]) continue;
+        const trace_record &r = records[i];
+        const auto it = buffers.find(r.block);
+        switch(trace_op(r.op))
+        {
+            case trace_op::allocate:
+            {
+                auto &e = buffers.insert_or_assign(r.block,
+                    entry{buffer(r.n, a)}).first->second;
+                touch(e.buf, 0);
+                break;
+            }
+            case trace_op::deallocate:
+                if(it != buffers.end()) buffers.erase(it);
+                break;
+            case trace_op::expand:
+            {
+                if(it == buffers.end()) break; // traced before the start
+                entry &e = it->second;
+                // The capacity the traced container needed
+                const std::size_t cap = e.buf.capacity(), need = r.m + r.n;
+                e.next = r.ok ? pending::none : pending::rename;
+                if(need <= cap) break;
+                const std::size_t least = need - cap;
+                report.attempts++;
+                if(e.buf.expand_by_at_least(std::max(
+                    growth.expand_increment(cap, least), least), least))
+                {
+                    growth.expanded(true);
+                    report.successes++;
+                    touch(e.buf, cap);
+                    break;
+                }
+                growth.expanded(false);
+                if(!r.ok) // the trace relocates next, it tells the size
+                {
+                    e.next = pending::relocate;
+                    e.least = least;
+                    break;
+                }
+                // Grown when full, so the traced capacity is the size
+                relocate(e, cap + std::max(
+                    growth.relocate_increment(cap, least), least), r.m);
+                break;
+            }
+            case trace_op::shrink:
+                if(it == buffers.end() || r.n >= it->second.buf.capacity())
+                    break;
+                report.attempts++;
+                if(it->second.buf.shrink_by(r.n)) report.successes++;
+                break;
+            case trace_op::relocate:
+            {
+                if(it == buffers.end()) // the first allocation
+                {
+                    auto &e = buffers.insert_or_assign(r.to,
+                        entry{buffer(r.n, a)}).first->second;
+                    touch(e.buf, 0);
+                    break;
+                }
+                entry &e = it->second;
+                if(e.next == pending::relocate)
+                {
+                    const std::size_t cap = e.buf.capacity();
+                    relocate(e, cap + std::max(
+                        growth.relocate_increment(cap, e.least), e.least),
+                        r.m);
+                }
+                else if(e.next == pending::none)
+                    relocate(e, r.n, r.m);
+                e.next = pending::none;
+                if(r.block != r.to) rename(it, r.to);
+                break;
+            }
+            case trace_op::reallocate:
+            {
+                if(it == buffers.end()) break;
+                buffer &b = it->second.buf;
+                const unsigned char *old = b.begin();
+                const std::size_t cap = b.capacity();
+                const std::size_t bytes = std::min<std::size_t>(r.m, cap);
+                b.reallocate(r.n, bytes);
+                if(b.capacity() > cap) touch(b, cap);
+                if(b.begin() != old)
+                {
+                    report.relocations++;
+                    report.bytes_copied += bytes;
+                }
+                if(r.block != r.to) rename(it, r.to);
+                break;
+            }
+        }
+    }
+    report.cycles = cycle_counter() - t0;
+    report.peak_rss = replay_detail::peak_rss();
+    return report;
+}
+//////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+#endif // header guard
@@ -0,0 +1,222 @@
+#ifndef __REALLOC_STATS_H
+#define __REALLOC_STATS_H
+
+#include<atomic>
+#include<mutex>
+#include<cstddef>
+#if defined(__x86_64__) || defined(__i386__)
+#include<x86intrin.h>
+#else
+#include<chrono>
+#endif
+
+namespace realloc4cpp {
+
+//----------------------------------------------------------------------------
+inline unsigned long long cycle_counter()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+}
+//////////////////////////////////////////////////////////////////////////////
+// Resizing statistics, in-place attempts are expand_by/shrink_by calls
+struct realloc_counters
+{
+    unsigned long long attempts = 0, successes = 0;
+    unsigned long long bytes_gained = 0; // by in-place expansion
+    unsigned long long bytes_released = 0; // by in-place shrinking
+    unsigned long long relocations = 0, bytes_copied = 0; // fallback
+    unsigned long long cycles = 0; // spent in all above
+
+    realloc_counters &operator+=(const realloc_counters &o)
+    {
+        attempts += o.attempts; successes += o.successes;
+        bytes_gained += o.bytes_gained; bytes_released += o.bytes_released;
+        relocations += o.relocations; bytes_copied += o.bytes_copied;
+        cycles += o.cycles;
+        return *this;
+    }
+    realloc_counters &operator-=(const realloc_counters &o)
+    {
+        attempts -= o.attempts; successes -= o.successes;
+        bytes_gained -= o.bytes_gained; bytes_released -= o.bytes_released;
+        relocations -= o.relocations; bytes_copied -= o.bytes_copied;
+        cycles -= o.cycles;
+        return *this;
+    }
+};
+//----------------------------------------------------------------------------
+inline realloc_counters operator-(realloc_counters a, const realloc_counters &b)
+{
+    return a -= b;
+}
+//////////////////////////////////////////////////////////////////////////////
+// Buffer events passed to Stats::trace(), recorded by realloc_trace.h
+enum class trace_op : unsigned char
+{
+    allocate,   // block of n bytes
+    deallocate, // block of n bytes
+    expand,     // block of m bytes by n bytes at least, preferred bytes
+    shrink,     // block by n bytes
+    relocate,   // block moved to `to` holding n bytes, m bytes of elements
+    reallocate  // block realloc()ed to `to` of n bytes, m bytes kept
+};
+struct trace_event
+{
+    trace_op op;
+    bool ok;
+    const void *block, *to;
+    std::size_t n, m;
+    std::size_t preferred = 0;
+    std::size_t capacity = 0; // bytes of the buffer after the event
+};
+//////////////////////////////////////////////////////////////////////////////
+// Statistics policy of raw_buffer that collects nothing
+struct no_realloc_stats
+{
+    static constexpr bool enabled = false;
+    static unsigned long long start() { return 0; }
+    static void expanded(bool , std::size_t , unsigned long long ) {}
+    static void shrunk(bool , std::size_t , unsigned long long ) {}
+    static void relocated(std::size_t , unsigned long long ) {}
+    static void trace(const trace_event & ) {}
+};
+//////////////////////////////////////////////////////////////////////////////
+// Statistics policy of raw_buffer. Containers using the same Tag share
+// the counters. Each thread updates its own cache line without atomic RMW,
+// snapshot() sums up all threads including finished ones.
+template<class Tag>
+class realloc_stats
+{
+    using counter = std::atomic<unsigned long long>;
+    struct alignas(64) slot
+    {
+        counter attempts{0}, successes{0}, bytes_gained{0},
+            bytes_released{0}, relocations{0}, bytes_copied{0}, cycles{0};
+        slot *prev = nullptr, *next = nullptr;
+
+        slot();
+        ~slot();
+        slot(const slot & ) = delete;
+        slot &operator=(const slot & ) = delete;
+
+        // Only the owner thread writes
+        static void add(counter &c, unsigned long long n)
+        {
+            c.store(c.load(std::memory_order_relaxed) + n,
+                std::memory_order_relaxed);
+        }
+        realloc_counters load() const;
+    };
+    struct registry
+    {
+        std::mutex mutex;
+        slot *head = nullptr;
+        realloc_counters retired; // from the finished threads
+    };
+    static registry &reg() { static registry r; return r; }
+    static slot &local() { thread_local slot s; return s; }
+    static void record(bool ok, std::size_t bytes,
+        unsigned long long t0, counter slot::*gained)
+    {
+        slot &s = local();
+        slot::add(s.attempts, 1);
+        if(ok)
+        {
+            slot::add(s.successes, 1);
+            slot::add(s.*gained, bytes);
+        }
+        slot::add(s.cycles, cycle_counter() - t0);
+    }
+public:
+    static constexpr bool enabled = true;
+
+    static unsigned long long start() { return cycle_counter(); }
+    static void expanded(bool ok, std::size_t bytes, unsigned long long t0)
+    {
+        record(ok, bytes, t0, &slot::bytes_gained);
+    }
+    static void shrunk(bool ok, std::size_t bytes, unsigned long long t0)
+    {
+        record(ok, bytes, t0, &slot::bytes_released);
+    }
+    static void relocated(std::size_t bytes, unsigned long long t0)
+    {
+        slot &s = local();
+        slot::add(s.relocations, 1);
+        slot::add(s.bytes_copied, bytes);
+        slot::add(s.cycles, cycle_counter() - t0);
+    }
+    static void trace(const trace_event & ) {}
+
+    static realloc_counters snapshot();
+};
+//////////////////////////////////////////////////////////////////////////////
+template<class Tag>
+realloc_stats<Tag>::slot::slot()
+{
+    registry &r = reg();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    if((next = r.head)) next->prev = this;
+    r.head = this;
+}
+//----------------------------------------------------------------------------
+template<class Tag>
+realloc_stats<Tag>::slot::~slot()
+{
+    registry &r = reg();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.retired += load();
+    if(next) next->prev = prev;
+    if(prev) prev->next = next; else r.head = next;
+}
+//----------------------------------------------------------------------------
+template<class Tag>
+realloc_counters realloc_stats<Tag>::slot::load() const
+{
+    constexpr auto relaxed = std::memory_order_relaxed;
+    realloc_counters c;
+    c.attempts = attempts.load(relaxed);
+    c.successes = successes.load(relaxed);
+    c.bytes_gained = bytes_gained.load(relaxed);
+    c.bytes_released = bytes_released.load(relaxed);
+    c.relocations = relocations.load(relaxed);
+    c.bytes_copied = bytes_copied.load(relaxed);
+    c.cycles = cycles.load(relaxed);
+    return c;
+}
+//----------------------------------------------------------------------------
+template<class Tag>
+realloc_counters realloc_stats<Tag>::snapshot()
+{
+    registry &r = reg();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    realloc_counters total = r.retired;
+    for(const slot *s = r.head; s; s = s->next) total += s->load();
+    return total;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Define REALLOC4CPP_STATS to collect statistics by default,
+// REALLOC4CPP_TRACE to record the trace of all the buffers: write it with
+//   trace_writer<default_realloc_stats> writer("file");
+#ifdef REALLOC4CPP_STATS
+using default_counting_stats = realloc_stats<void>;
+#else
+using default_counting_stats = no_realloc_stats;
+#endif
+#ifndef REALLOC4CPP_TRACE
+using default_realloc_stats = default_counting_stats;
+#endif
+
+} // namespace
+
+// Defines default_realloc_stats, whichever header is included first
+#ifdef REALLOC4CPP_TRACE
+#include"realloc_trace.h"
+#endif
+
+#endif // header guard
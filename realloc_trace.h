@@ -0,0 +1,249 @@
+#ifndef __REALLOC_TRACE_H
+#define __REALLOC_TRACE_H
+
+#include"realloc_stats.h"
+#include<atomic>
+#include<mutex>
+#include<thread>
+#include<condition_variable>
+#include<chrono>
+#include<memory>
+#include<vector>
+#include<algorithm>
+#include<iterator>
+#include<system_error>
+#include<cerrno>
+#include<cstdio>
+#include<cstdint>
+
+namespace realloc4cpp {
+
+//////////////////////////////////////////////////////////////////////////////
+// trace_event as it is written to the trace file
+struct trace_record
+{
+    std::uint64_t tsc; // cycle_counter() after the event
+    std::uint64_t block, to; // addresses
+    std::uint64_t n, m; // bytes, see trace_op
+    std::uint64_t preferred, capacity; // bytes, see trace_event
+    std::uint32_t thread; // number of the thread in the trace
+    std::uint8_t op, ok;
+    std::uint16_t reserved;
+};
+static_assert(sizeof(trace_record) == 64);
+
+// The trace file is this header followed by the records of all threads.
+// Records of one thread follow in their order, threads are interleaved.
+struct trace_file_header
+{
+    char magic[8];
+    std::uint32_t version, record_size;
+
+    static constexpr char signature[8] = {'R','4','C','T','R','A','C','E'};
+    static constexpr std::uint32_t current_version = 2;
+};
+//////////////////////////////////////////////////////////////////////////////
+// Statistics policy of raw_buffer recording every allocate, expand_by,
+// shrink_by, deallocate and relocation of the buffers using it.
+// Stats collects the counters as usual. Containers using the same Tag
+// share the trace.
+//
+// Each thread writes to its own lock-free ring of RingSize records,
+// drain() (trace_writer below) empties them. Records that do not fit
+// into a full ring are dropped and counted.
+template<class Tag, class Stats = no_realloc_stats,
+    std::size_t RingSize = std::size_t(1) << 14>
+class realloc_trace : public Stats
+{
+    static_assert((RingSize & (RingSize - 1)) == 0,
+        "RingSize must be a power of 2");
+    using counter = std::atomic<std::size_t>;
+    struct slot
+    {
+        std::unique_ptr<trace_record[]> ring{new trace_record[RingSize]};
+        counter head{0}, tail{0}; // written by the owner and drain()
+        std::atomic<unsigned long long> dropped{0};
+        std::uint32_t thread;
+        slot *prev = nullptr, *next = nullptr;
+
+        slot();
+        ~slot();
+        slot(const slot & ) = delete;
+        slot &operator=(const slot & ) = delete;
+
+        void push(const trace_record &r)
+        {
+            const std::size_t h = head.load(std::memory_order_relaxed);
+            if(h - tail.load(std::memory_order_acquire) == RingSize)
+            {
+                dropped.store(dropped.load(std::memory_order_relaxed) + 1,
+                    std::memory_order_relaxed);
+                return;
+            }
+            ring[h % RingSize] = r;
+            head.store(h + 1, std::memory_order_release);
+        }
+        // Under the registry mutex
+        template<class Out>
+        void drain(Out &out)
+        {
+            const std::size_t t = tail.load(std::memory_order_relaxed);
+            const std::size_t h = head.load(std::memory_order_acquire);
+            if(t == h) return;
+            const std::size_t first = t % RingSize, last = h % RingSize;
+            if(first < last) out(&ring[first], last - first);
+            else
+            {
+                out(&ring[first], RingSize - first);
+                if(last) out(&ring[0], last);
+            }
+            tail.store(h, std::memory_order_release);
+        }
+    };
+    struct registry
+    {
+        std::mutex mutex;
+        slot *head = nullptr;
+        std::vector<trace_record> retired; // from the finished threads
+        unsigned long long dropped = 0; // by the finished threads
+        std::uint32_t threads = 0;
+    };
+    static registry &reg() { static registry r; return r; }
+    static slot &local() { thread_local slot s; return s; }
+public:
+    static void trace(const trace_event &e)
+    {
+        slot &s = local();
+        s.push({cycle_counter(),
+            reinterpret_cast<std::uintptr_t>(e.block),
+            reinterpret_cast<std::uintptr_t>(e.to),
+            e.n, e.m, e.preferred, e.capacity, s.thread,
+            static_cast<std::uint8_t>(e.op), e.ok, 0});
+    }
+    // Passes the records collected so far to
+    // out(const trace_record *records, std::size_t n)
+    template<class Out>
+    static void drain(Out out);
+    static unsigned long long dropped();
+};
+//----------------------------------------------------------------------------
+template<class Tag, class Stats, std::size_t RingSize>
+realloc_trace<Tag,Stats,RingSize>::slot::slot()
+{
+    registry &r = reg();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    thread = r.threads++;
+    if((next = r.head)) next->prev = this;
+    r.head = this;
+}
+//----------------------------------------------------------------------------
+template<class Tag, class Stats, std::size_t RingSize>
+realloc_trace<Tag,Stats,RingSize>::slot::~slot()
+{
+    registry &r = reg();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    auto keep = [&r](const trace_record *p, std::size_t n) {
+        r.retired.insert(r.retired.end(), p, p + n);
+    };
+    drain(keep);
+    r.dropped += dropped.load(std::memory_order_relaxed);
+    if(next) next->prev = prev;
+    if(prev) prev->next = next; else r.head = next;
+}
+//----------------------------------------------------------------------------
+template<class Tag, class Stats, std::size_t RingSize>
+template<class Out>
+void realloc_trace<Tag,Stats,RingSize>::drain(Out out)
+{
+    registry &r = reg();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    if(!r.retired.empty())
+    {
+        out(r.retired.data(), r.retired.size());
+        r.retired.clear();
+    }
+    for(slot *s = r.head; s; s = s->next) s->drain(out);
+}
+//----------------------------------------------------------------------------
+template<class Tag, class Stats, std::size_t RingSize>
+unsigned long long realloc_trace<Tag,Stats,RingSize>::dropped()
+{
+    registry &r = reg();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    unsigned long long n = r.dropped;
+    for(const slot *s = r.head; s; s = s->next)
+        n += s->dropped.load(std::memory_order_relaxed);
+    return n;
+}
+//////////////////////////////////////////////////////////////////////////////
+// Writes the records of Trace (some realloc_trace) to the file every
+// period_ms milliseconds from a background thread and once more when
+// destroyed. Throws std::system_error if the file cannot be created.
+template<class Trace>
+class trace_writer
+{
+    std::FILE *file;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stop = false;
+    std::thread thread;
+
+    void flush()
+    {
+        Trace::drain([this](const trace_record *p, std::size_t n) {
+            std::fwrite(p, sizeof *p, n, file);
+        });
+        std::fflush(file);
+    }
+    void run(std::chrono::milliseconds period)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while(!wake.wait_for(lock, period, [this] { return stop; }))
+            flush();
+    }
+public:
+    explicit trace_writer(const char *path, unsigned period_ms = 100)
+    {
+        file = std::fopen(path, "wb");
+        if(!file) throw std::system_error(errno, std::system_category(),
+            path);
+        trace_file_header h{{}, trace_file_header::current_version,
+            sizeof(trace_record)};
+        std::copy(std::begin(h.signature), std::end(h.signature), h.magic);
+        std::fwrite(&h, sizeof h, 1, file);
+        try
+        {
+            thread = std::thread([this, period_ms] {
+                run(std::chrono::milliseconds(period_ms));
+            });
+        }
+        catch(...)
+        {
+            std::fclose(file);
+            throw;
+        }
+    }
+    trace_writer(const trace_writer & ) = delete;
+    trace_writer &operator=(const trace_writer & ) = delete;
+    ~trace_writer()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        wake.notify_one();
+        thread.join();
+        flush();
+        std::fclose(file);
+    }
+};
+//////////////////////////////////////////////////////////////////////////////
+// All the buffers are traced (see realloc_stats.h)
+#ifdef REALLOC4CPP_TRACE
+using default_realloc_stats = realloc_trace<void, default_counting_stats>;
+#endif
+//////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+#endif // header guard
@@ -1,60 +1,107 @@
 #ifndef __REALLOCATOR_H
 #define __REALLOCATOR_H
 
+#include"allocator_traits.h"
 #include<new>
+#include<algorithm>
+#include<mutex>
+#include<vector>
+#include<stdexcept>
 #include<type_traits>
 #include<jemalloc/jemalloc.h>
 
 namespace realloc4cpp {
 
 //////////////////////////////////////////////////////////////////////////////
+// jemalloc calls shared by the allocators below, flags are MALLOCX_* ones
+// and must include MALLOCX_ALIGN(Alignment) if Alignment > alignof(T).
+// When T fits Alignment evenly, blocks hold the whole number of
+// Alignment-sized vectors: no scalar tail for SIMD loops.
 template<class T, std::size_t Alignment = alignof(T)>
-struct reallocator
+struct mallocx_ops
 {
-    using value_type = T;
     using size_type = std::size_t;
-    using is_always_equal = std::true_type;
-    template<class U> struct rebind { using other = reallocator<U>; };
 
-    reallocator() = default;
-    template<class U, std::size_t A2>
-    constexpr reallocator(const reallocator<U,A2> &) noexcept {}
+    static_assert((Alignment & (Alignment - 1)) == 0,
+        "Alignment must be a power of 2");
+    static_assert(Alignment >= alignof(T), "Alignment is too small");
 
-    [[nodiscard]] T *allocate(size_type n)
+    // Elements per vector
+    static constexpr size_type lanes =
+        Alignment % sizeof(T) == 0 ? Alignment / sizeof(T) : 1;
+    static constexpr size_type padded(size_type n)
+    {
+        return (n + lanes - 1) / lanes * lanes;
+    }
+    // padded() does not overflow below
+    static constexpr size_type max_size()
     {
-        void *p = je_mallocx(n * sizeof(T), MALLOCX_ALIGN(Alignment));
+        return ~size_type(0) / sizeof(T) - lanes;
+    }
+
+    [[nodiscard]] static T *allocate(size_type n, int flags)
+    {
+        void *p = je_mallocx(padded(n) * sizeof(T), flags);
         if(!p) throw std::bad_alloc();
         return static_cast<T*>(p);
     }
-    [[nodiscard]] T *allocate_at_least(size_type &n)
+    [[nodiscard]] static T *allocate_at_least(size_type &n, int flags)
     {
-        auto *p = allocate(n);
-        n = je_sallocx(p, MALLOCX_ALIGN(Alignment)) / sizeof(T);
+        auto *p = allocate(n, flags);
+        n = je_sallocx(p, flags) / sizeof(T);
         return p;
     }
-    void deallocate(T *p, size_type n)
+    // flags must have the same alignment as for the allocation
+    static void deallocate(T *p, size_type n, int flags)
     {
-        je_sdallocx(p, n, 0);
+        je_sdallocx(p, n * sizeof(T), flags);
     }
-    [[nodiscard]] bool expand_by(T *p,
-        size_type &size, size_type preferred_n, size_type least_n)
+    static size_type good_size(size_type n, int flags)
+    {
+        if(!n) return 0;
+        // nallocx() returns 0 above the largest size class
+        const std::size_t bytes = n <= max_size() ?
+            je_nallocx(padded(n) * sizeof(T), flags) : 0;
+        if(!bytes) throw std::length_error("Exceeded the largest size class");
+        return bytes / sizeof(T);
+    }
+    // Smaller blocks come from slabs and are never resized in place
+    // (with 4KiB pages, http://jemalloc.net/jemalloc.3.html)
+    static constexpr size_type min_resizable_size()
+    {
+        return padded(((std::size_t(16) << 10) + sizeof(T) - 1) / sizeof(T));
+    }
+    [[nodiscard]] static bool expand_by(T *p, size_type &size,
+        size_type preferred_n, size_type least_n, int flags)
     {
         const auto old_size = size;
+        const auto least = padded(old_size + least_n);
+        const auto preferred = std::max(padded(old_size + preferred_n), least);
         const auto new_size_bytes = je_xallocx(p,
-            (old_size + least_n) * sizeof(T),
-            (preferred_n - least_n) * sizeof(T),
-            MALLOCX_ALIGN(Alignment)
+            least * sizeof(T),
+            (preferred - least) * sizeof(T),
+            flags
         );
         const auto new_size = new_size_bytes / sizeof(T);
         if(new_size <= old_size) return false;
         size = new_size;
         return true;
     }
-    [[nodiscard]] bool shrink_by(T *p, size_type &size, size_type n)
+    // Can move the block (including mremap() for huge ones)
+    [[nodiscard]] static T *reallocate(T *p,
+        size_type &size, size_type n, int flags)
+    {
+        void *new_p = je_rallocx(p, padded(n) * sizeof(T), flags);
+        if(!new_p) throw std::bad_alloc();
+        size = je_sallocx(new_p, flags) / sizeof(T);
+        return static_cast<T*>(new_p);
+    }
+    [[nodiscard]] static bool shrink_by(T *p,
+        size_type &size, size_type n, int flags)
     {
         const auto old_size = size;
         const auto new_size_bytes = je_xallocx(p,
-            (size - n) * sizeof(T), 0, MALLOCX_ALIGN(Alignment));
+            padded(size - n) * sizeof(T), 0, flags);
         const auto new_size = new_size_bytes / sizeof(T);
         if(new_size >= old_size) return false;
         size = new_size;
@@ -62,10 +109,221 @@ struct reallocator
     }
 };
 //////////////////////////////////////////////////////////////////////////////
-template<class U, std::size_t A1, class V, std::size_t A2>
-inline bool operator==(reallocator<U,A1>, reallocator<V,A2>) { return true; }
-template<class U, std::size_t A1, class V, std::size_t A2>
-inline bool operator!=(reallocator<U,A1>, reallocator<V,A2>) { return false; }
+// Alignment is the minimum one, T can need more (see block_alignment())
+template<class T, std::size_t Alignment = alignof(T)>
+struct reallocator
+{
+    using value_type = T;
+    using size_type = std::size_t;
+    using is_always_equal = std::true_type;
+    template<class U> struct rebind
+        { using other = reallocator<U, Alignment>; };
+
+    reallocator() = default;
+    template<class U>
+    constexpr reallocator(const reallocator<U,Alignment> &) noexcept {}
+
+    [[nodiscard]] T *allocate(size_type n)
+    {
+        return ops::allocate(n, flags);
+    }
+    [[nodiscard]] T *allocate_at_least(size_type &n)
+    {
+        return ops::allocate_at_least(n, flags);
+    }
+    void deallocate(T *p, size_type n)
+    {
+        ops::deallocate(p, n, flags);
+    }
+    size_type good_size(size_type n) const
+    {
+        return ops::good_size(n, flags);
+    }
+    static constexpr size_type min_resizable_size()
+    {
+        return ops::min_resizable_size();
+    }
+    [[nodiscard]] bool expand_by(T *p,
+        size_type &size, size_type preferred_n, size_type least_n)
+    {
+        return ops::expand_by(p, size, preferred_n, least_n, flags);
+    }
+    [[nodiscard]] T *reallocate(T *p, size_type &size, size_type n)
+    {
+        return ops::reallocate(p, size, n, flags);
+    }
+    [[nodiscard]] bool shrink_by(T *p, size_type &size, size_type n)
+    {
+        return ops::shrink_by(p, size, n, flags);
+    }
+    static constexpr std::size_t alignment()
+    {
+        return block_alignment<T>(Alignment);
+    }
+private:
+    using ops = mallocx_ops<T, alignment()>;
+    static constexpr int flags = MALLOCX_ALIGN(alignment());
+};
+//////////////////////////////////////////////////////////////////////////////
+// Only the allocators with the same Alignment convert to each other, so
+// all of them free the blocks of each other with the right sized
+// deallocation
+template<class U, class V, std::size_t A>
+inline bool operator==(reallocator<U,A>, reallocator<V,A>) { return true; }
+template<class U, class V, std::size_t A>
+inline bool operator!=(reallocator<U,A>, reallocator<V,A>) { return false; }
+
+//////////////////////////////////////////////////////////////////////////////
+// Creates a new jemalloc arena and returns its index.
+// Arenas are never destroyed: blocks from them can outlive the creator.
+inline unsigned create_arena()
+{
+    unsigned arena;
+    std::size_t len = sizeof arena;
+    if(je_mallctl("arenas.create", &arena, &len, nullptr, 0))
+        throw std::bad_alloc();
+    return arena;
+}
+//----------------------------------------------------------------------------
+// Dedicated arena of the calling thread, created on the first call.
+// The arenas of the exited threads are given to the new ones, so thread
+// churn does not exhaust the arena indices.
+inline unsigned thread_arena()
+{
+    struct pool
+    {
+        std::mutex mutex;
+        std::vector<unsigned> arenas;
+    };
+    static pool &idle = *new pool; // threads can exit after static dtors
+    struct owner
+    {
+        unsigned arena;
+
+        owner()
+        {
+            std::lock_guard<std::mutex> lock(idle.mutex);
+            if(idle.arenas.empty()) arena = create_arena();
+            else
+            {
+                arena = idle.arenas.back();
+                idle.arenas.pop_back();
+            }
+        }
+        ~owner()
+        {
+            std::lock_guard<std::mutex> lock(idle.mutex);
+            try { idle.arenas.push_back(arena); }
+            catch(const std::bad_alloc & ) {} // the arena is lost then
+        }
+    };
+    thread_local const owner o;
+    return o.arena;
+}
+//----------------------------------------------------------------------------
+// Arena shared by all callers passing the same NUMA node number
+inline unsigned node_arena(unsigned node)
+{
+    constexpr unsigned max_nodes = 64;
+    static unsigned arenas[max_nodes];
+    static std::once_flag created[max_nodes];
+    if(node >= max_nodes) throw std::out_of_range("node_arena()");
+    std::call_once(created[node], [node] { arenas[node] = create_arena(); });
+    return arenas[node];
+}
+//////////////////////////////////////////////////////////////////////////////
+// reallocator bound to some jemalloc arena. A buffer that is the only
+// user of its arena has no neighbours, so xallocx() succeeds much more often.
+// tcache_flags is 0 (thread cache of the calling thread), MALLOCX_TCACHE_NONE
+// or MALLOCX_TCACHE(tcache_index).
+// The default one uses the automatic arenas, pass create_arena(),
+// node_arena() or thread_arena() for a dedicated one.
+template<class T, std::size_t Alignment = alignof(T)>
+class arena_reallocator
+{
+    static constexpr std::size_t align = block_alignment<T>(Alignment);
+    using ops = mallocx_ops<T, align>;
+    unsigned arena_;
+    int tcache_;
+
+    template<class, std::size_t> friend class arena_reallocator;
+
+    int flags() const noexcept
+    {
+        return MALLOCX_ALIGN(align) | tcache_ |
+            (arena_ == automatic_arenas ? 0 : MALLOCX_ARENA(arena_));
+    }
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+    // the buffer always goes together with its allocator
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+    using is_always_equal = std::false_type;
+    template<class U> struct rebind
+        { using other = arena_reallocator<U, Alignment>; };
+
+    // arena() of the allocators using the automatic arenas
+    static constexpr unsigned automatic_arenas = ~0u;
+
+    arena_reallocator() noexcept : arena_reallocator(automatic_arenas) {}
+    explicit arena_reallocator(unsigned arena, int tcache_flags = 0) noexcept
+        : arena_(arena), tcache_(tcache_flags) {}
+    template<class U>
+    arena_reallocator(const arena_reallocator<U,Alignment> &o) noexcept
+        : arena_(o.arena_), tcache_(o.tcache_) {}
+
+    [[nodiscard]] T *allocate(size_type n)
+    {
+        return ops::allocate(n, flags());
+    }
+    [[nodiscard]] T *allocate_at_least(size_type &n)
+    {
+        return ops::allocate_at_least(n, flags());
+    }
+    void deallocate(T *p, size_type n)
+    {
+        ops::deallocate(p, n, MALLOCX_ALIGN(align) | tcache_);
+    }
+    size_type good_size(size_type n) const
+    {
+        return ops::good_size(n, flags());
+    }
+    static constexpr size_type min_resizable_size()
+    {
+        return ops::min_resizable_size();
+    }
+    [[nodiscard]] bool expand_by(T *p,
+        size_type &size, size_type preferred_n, size_type least_n)
+    {
+        return ops::expand_by(p, size, preferred_n, least_n, flags());
+    }
+    [[nodiscard]] T *reallocate(T *p, size_type &size, size_type n)
+    {
+        return ops::reallocate(p, size, n, flags());
+    }
+    [[nodiscard]] bool shrink_by(T *p, size_type &size, size_type n)
+    {
+        return ops::shrink_by(p, size, n, flags());
+    }
+
+    unsigned arena() const noexcept { return arena_; }
+    int tcache_flags() const noexcept { return tcache_; }
+    static constexpr std::size_t alignment() { return align; }
+
+    template<class U>
+    bool operator==(const arena_reallocator<U,Alignment> &o) const noexcept
+    {
+        return arena_ == o.arena_ && tcache_ == o.tcache_;
+    }
+    template<class U>
+    bool operator!=(const arena_reallocator<U,Alignment> &o) const noexcept
+    {
+        return !(*this == o);
+    }
+};
+//////////////////////////////////////////////////////////////////////////////
 
 } // namespace
 
@@ -0,0 +1,234 @@
+#ifndef __RELOCATION_POLICY_H
+#define __RELOCATION_POLICY_H
+
+#include"allocator_traits.h"
+#include<algorithm>
+#include<atomic>
+#include<condition_variable>
+#include<deque>
+#include<exception>
+#include<iterator>
+#include<mutex>
+#include<thread>
+#include<type_traits>
+#include<vector>
+
+namespace realloc4cpp {
+
+//////////////////////////////////////////////////////////////////////////////
+// Relocation policies of autogrow_array: how the elements are moved
+// to the new buffer when the old one cannot be resized in place.
+//
+//   // moves [first, last) to the raw memory at dest with the allocator a
+//   // of dest, returns the end; if an exception is thrown no element
+//   // remains constructed in dest
+//   template<class Alloc, class T>
+//   static T *uninitialized_move(Alloc &a, T *first, T *last, T *dest);
+//   // the same but copies, for T with a throwing move
+//   template<class Alloc, class T>
+//   static T *uninitialized_copy(Alloc &a,
+//       const T *first, const T *last, T *dest);
+//////////////////////////////////////////////////////////////////////////////
+struct serial_relocation
+{
+    template<class Alloc, class T>
+    static T *uninitialized_move(Alloc &a, T *first, T *last, T *dest)
+    {
+        return construct(a, std::make_move_iterator(first),
+            std::make_move_iterator(last), dest);
+    }
+    template<class Alloc, class T>
+    static T *uninitialized_copy(Alloc &a,
+        const T *first, const T *last, T *dest)
+    {
+        return construct(a, first, last, dest);
+    }
+private:
+    template<class Alloc, class It, class T>
+    static T *construct(Alloc &a, It first, It last, T *dest)
+    {
+        using A = allocator_traits<Alloc>;
+        T *p = dest;
+        try
+        {
+            for(; first != last; ++first, ++p) A::construct(a, p, *first);
+        }
+        catch(...)
+        {
+            while(p != dest) A::destroy(a, --p);
+            throw;
+        }
+        return p;
+    }
+};
+//////////////////////////////////////////////////////////////////////////////
+// Worker threads shared by all the parallel relocations, started on the
+// first one. The caller takes part in its own batch, so it completes even
+// if no worker is free (or none could be started).
+class relocation_pool
+{
+    struct batch
+    {
+        void (*call)(const void *, unsigned);
+        const void *f;
+        unsigned n;
+        std::atomic<unsigned> next{0};
+        unsigned done = 0, users = 0; // under mutex
+    };
+    std::mutex mutex;
+    std::condition_variable work, finished;
+    std::deque<batch *> queue;
+    std::vector<std::thread> workers;
+
+    relocation_pool()
+    {
+        const unsigned n = std::thread::hardware_concurrency();
+        try
+        {
+            for(unsigned i = 1; i < n; i++) workers.emplace_back([this] {
+                worker();
+            });
+        }
+        catch(...) {} // fewer workers then
+    }
+    // Calls b.f(i) for the indices of b nobody has taken
+    unsigned take(batch &b)
+    {
+        unsigned i, count = 0;
+        for(; (i = b.next.fetch_add(1)) < b.n; count++) b.call(b.f, i);
+        return count;
+    }
+    [[noreturn]] void worker()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        for(;;)
+        {
+            work.wait(lock, [this] { return !queue.empty(); });
+            batch &b = *queue.front();
+            if(b.next.load() >= b.n) // all taken, the rest is running
+            {
+                queue.pop_front();
+                continue;
+            }
+            b.users++;
+            lock.unlock();
+            const unsigned count = take(b);
+            lock.lock();
+            b.done += count;
+            if(--b.users == 0 && b.done == b.n) finished.notify_all();
+        }
+    }
+public:
+    relocation_pool(const relocation_pool & ) = delete;
+    relocation_pool &operator=(const relocation_pool & ) = delete;
+
+    // Never destroyed: a relocation can happen during the static
+    // destruction, the workers just block at exit
+    static relocation_pool &instance()
+    {
+        static relocation_pool &pool = *new relocation_pool;
+        return pool;
+    }
+    // Calls f(i) for every i in [0, n), f must not throw
+    template<class F>
+    void run(unsigned n, const F &f)
+    {
+        batch b;
+        b.call = [](const void *g, unsigned i) {
+            (*static_cast<const F *>(g))(i);
+        };
+        b.f = &f;
+        b.n = n;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queue.push_back(&b);
+        }
+        work.notify_all();
+        const unsigned count = take(b);
+        std::unique_lock<std::mutex> lock(mutex);
+        b.done += count;
+        finished.wait(lock, [&b] { return b.users == 0 && b.done == b.n; });
+        const auto it = std::find(queue.begin(), queue.end(), &b);
+        if(it != queue.end()) queue.erase(it);
+    }
+};
+//////////////////////////////////////////////////////////////////////////////
+// Splits the move (or copy) of MinElements or more elements into ranges
+// moved by Threads threads (0 means hardware_concurrency()) including the
+// caller. The threads come from relocation_pool. Alloc::construct() and
+// destroy() are called concurrently.
+template<std::size_t MinElements = std::size_t(1) << 16, unsigned Threads = 0>
+struct parallel_relocation
+{
+    template<class Alloc, class T>
+    static T *uninitialized_move(Alloc &a, T *first, T *last, T *dest)
+    {
+        return relocate(a, first, last, dest);
+    }
+    template<class Alloc, class T>
+    static T *uninitialized_copy(Alloc &a,
+        const T *first, const T *last, T *dest)
+    {
+        return relocate(a, first, last, dest);
+    }
+private:
+    // Copies if U is const T, moves otherwise
+    template<class Alloc, class U, class T>
+    static T *relocate(Alloc &a, U *first, U *last, T *dest);
+    template<class Alloc, class U, class T>
+    static T *relocate_serial(Alloc &a, U *first, U *last, T *dest)
+    {
+        if constexpr(std::is_const<U>::value)
+            return serial_relocation::uninitialized_copy(a, first, last, dest);
+        else
+            return serial_relocation::uninitialized_move(a, first, last, dest);
+    }
+};
+//----------------------------------------------------------------------------
+template<std::size_t MinElements, unsigned Threads>
+template<class Alloc, class U, class T>
+T *parallel_relocation<MinElements,Threads>::relocate(
+    Alloc &a, U *first, U *last, T *dest)
+{
+    const std::size_t n = last - first;
+    unsigned threads = Threads ? Threads : std::thread::hardware_concurrency();
+    if(n < MinElements || threads < 2)
+        return relocate_serial(a, first, last, dest);
+    // Not too small ranges
+    const std::size_t min_range = std::max<std::size_t>(MinElements / 4, 1);
+    if(n / threads < min_range) threads = unsigned(n / min_range);
+
+    // Range i is [i * n / threads, (i + 1) * n / threads)
+    const auto bound = [=](unsigned i) { return n * i / threads; };
+    std::vector<std::exception_ptr> errors(threads);
+    const auto move_range = [&](unsigned i) {
+        try
+        {
+            // Rolls back its own range on exception
+            relocate_serial(a,
+                first + bound(i), first + bound(i + 1), dest + bound(i));
+        }
+        catch(...)
+        {
+            errors[i] = std::current_exception();
+        }
+    };
+    relocation_pool::instance().run(threads, move_range);
+
+    std::exception_ptr error;
+    for(auto &e : errors) if(e) { error = e; break; }
+    if(!error) return dest + n;
+    // Destroy the ranges that succeeded
+    for(unsigned i = 0; i < threads; i++)
+    {
+        if(errors[i]) continue;
+        for(T *p = dest + bound(i); p != dest + bound(i + 1); ++p)
+            allocator_traits<Alloc>::destroy(a, p);
+    }
+    std::rethrow_exception(error);
+}
+//////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+#endif // header guard
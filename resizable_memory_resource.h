@@ -0,0 +1,226 @@
+#ifndef __RESIZABLE_MEMORY_RESOURCE_H
+#define __RESIZABLE_MEMORY_RESOURCE_H
+
+#include"allocator_traits.h"
+#include"bump_reallocator.h"
+#include<memory_resource>
+#include<algorithm>
+#include<limits>
+#include<new>
+#include<cstddef>
+
+namespace realloc4cpp {
+
+//////////////////////////////////////////////////////////////////////////////
+// std::pmr::memory_resource that can resize its blocks in place.
+// The arguments are in bytes and mean the same as for the expand_by(),
+// shrink_by() and allocate_at_least() of the allocators. The block is
+// identified by the pointer, the size and the alignment as in deallocate().
+// Only the resources overriding the do_*() below ever succeed.
+class resizable_memory_resource : public std::pmr::memory_resource
+{
+    static constexpr std::size_t max_align = alignof(std::max_align_t);
+
+    virtual void *do_allocate_at_least(std::size_t &bytes,
+        std::size_t alignment)
+    {
+        return allocate(bytes, alignment);
+    }
+    virtual bool do_expand(void * , std::size_t & , std::size_t ,
+        std::size_t , std::size_t )
+    {
+        return false;
+    }
+    virtual bool do_shrink(void * , std::size_t & , std::size_t ,
+        std::size_t )
+    {
+        return false;
+    }
+public:
+    // bytes is the size requested on input, obtained on output
+    [[nodiscard]] void *allocate_at_least(std::size_t &bytes,
+        std::size_t alignment = max_align)
+    {
+        return do_allocate_at_least(bytes, alignment);
+    }
+    // size is the current one on input, the new one on output
+    [[nodiscard]] bool expand(void *p, std::size_t &size,
+        std::size_t preferred, std::size_t least,
+        std::size_t alignment = max_align)
+    {
+        return do_expand(p, size, preferred, least, alignment);
+    }
+    [[nodiscard]] bool shrink(void *p, std::size_t &size, std::size_t n,
+        std::size_t alignment = max_align)
+    {
+        return do_shrink(p, size, n, alignment);
+    }
+};
+//----------------------------------------------------------------------------
+// r if it can resize the blocks, nullptr otherwise
+inline resizable_memory_resource *to_resizable(
+    std::pmr::memory_resource *r) noexcept
+{
+    return dynamic_cast<resizable_memory_resource*>(r);
+}
+//////////////////////////////////////////////////////////////////////////////
+// polymorphic_allocator passing expand_by(), shrink_by() and
+// allocate_at_least() to its resource, so the containers resize in place
+// whenever the resource is a resizable_memory_resource. The resource is
+// picked at run time: one instantiation of the container serves all.
+template<class T>
+class resizable_polymorphic_allocator
+    : public std::pmr::polymorphic_allocator<T>
+{
+    using base = std::pmr::polymorphic_allocator<T>;
+    resizable_memory_resource *r_; // resource() if it is resizable
+
+    template<class> friend class resizable_polymorphic_allocator;
+
+    static std::size_t bytes(std::size_t n)
+    {
+        if(n > std::numeric_limits<std::size_t>::max() / sizeof(T))
+            throw std::bad_array_new_length();
+        return n * sizeof(T);
+    }
+public:
+    using size_type = std::size_t;
+
+    resizable_polymorphic_allocator() noexcept
+        : resizable_polymorphic_allocator(std::pmr::get_default_resource()) {}
+    resizable_polymorphic_allocator(std::pmr::memory_resource *r) noexcept
+        : base(r), r_(to_resizable(r)) {}
+    template<class U>
+    resizable_polymorphic_allocator(
+        const resizable_polymorphic_allocator<U> &o) noexcept
+        : base(o.resource()), r_(o.r_) {}
+    resizable_polymorphic_allocator(
+        const resizable_polymorphic_allocator & ) = default;
+    resizable_polymorphic_allocator &operator=(
+        const resizable_polymorphic_allocator & ) = delete;
+
+    [[nodiscard]] T *allocate_at_least(size_type &n)
+    {
+        if(!r_) return base::allocate(n);
+        std::size_t size = bytes(n);
+        T *p = static_cast<T*>(r_->allocate_at_least(size, alignof(T)));
+        n = size / sizeof(T);
+        return p;
+    }
+    [[nodiscard]] bool expand_by(T *p,
+        size_type &size, size_type preferred_n, size_type least_n)
+    {
+        std::size_t new_size = size * sizeof(T);
+        if(!r_ || !r_->expand(p, new_size, bytes(preferred_n),
+            bytes(least_n), alignof(T))) return false;
+        size = new_size / sizeof(T);
+        return true;
+    }
+    [[nodiscard]] bool shrink_by(T *p, size_type &size, size_type n)
+    {
+        std::size_t new_size = size * sizeof(T);
+        if(!r_ || !r_->shrink(p, new_size, n * sizeof(T), alignof(T)))
+            return false;
+        size = new_size / sizeof(T);
+        return true;
+    }
+
+    // As polymorphic_allocator: the copy uses the default resource
+    resizable_polymorphic_allocator select_on_container_copy_construction()
+        const
+    {
+        return resizable_polymorphic_allocator();
+    }
+};
+//////////////////////////////////////////////////////////////////////////////
+// Monotonic resource over bump_arena: the last block is resized in place,
+// upstream serves what does not fit (and the alignments above Alignment)
+// and resizes its blocks if it is resizable. As the arena, not
+// thread-safe.
+template<std::size_t N, std::size_t Alignment = alignof(std::max_align_t)>
+class bump_memory_resource : public resizable_memory_resource
+{
+public:
+    using arena_type = bump_arena<N, Alignment>;
+private:
+    arena_type *a_;
+    std::pmr::memory_resource *upstream_;
+    resizable_memory_resource *resizable_upstream_;
+
+    static char *bytes(void *p) { return static_cast<char*>(p); }
+
+    void *do_allocate(std::size_t size, std::size_t alignment) override
+    {
+        if(alignment <= Alignment)
+            if(char *p = a_->allocate(size)) return p;
+        return upstream_->allocate(size, alignment);
+    }
+    void do_deallocate(void *p, std::size_t size,
+        std::size_t alignment) override
+    {
+        if(a_->owns(p)) a_->deallocate(bytes(p), size);
+        else upstream_->deallocate(p, size, alignment);
+    }
+    bool do_is_equal(
+        const std::pmr::memory_resource &o) const noexcept override
+    {
+        return this == &o;
+    }
+    void *do_allocate_at_least(std::size_t &size,
+        std::size_t alignment) override
+    {
+        if(alignment <= Alignment)
+            if(char *p = a_->allocate(size))
+            {
+                // Take the alignment padding too
+                size = arena_type::block_size(size);
+                return p;
+            }
+        if(resizable_upstream_)
+            return resizable_upstream_->allocate_at_least(size, alignment);
+        return upstream_->allocate(size, alignment);
+    }
+    bool do_expand(void *p, std::size_t &size, std::size_t preferred,
+        std::size_t least, std::size_t alignment) override
+    {
+        if(!a_->owns(p)) return resizable_upstream_ &&
+            resizable_upstream_->expand(p, size, preferred, least, alignment);
+        const std::size_t room = a_->room(bytes(p), size);
+        if(room < size + least) return false;
+        size = std::min(size + std::max(preferred, least), room);
+        a_->resize_last(bytes(p), size);
+        return true;
+    }
+    bool do_shrink(void *p, std::size_t &size, std::size_t n,
+        std::size_t alignment) override
+    {
+        if(!a_->owns(p)) return resizable_upstream_ &&
+            resizable_upstream_->shrink(p, size, n, alignment);
+        // Not the last one: the tail cannot be reused
+        if(!a_->room(bytes(p), size)) return false;
+        a_->resize_last(bytes(p), size -= n);
+        return true;
+    }
+public:
+    explicit bump_memory_resource(arena_type &a,
+        std::pmr::memory_resource *upstream =
+            std::pmr::get_default_resource()) noexcept
+    :
+        a_(&a), upstream_(upstream),
+        resizable_upstream_(to_resizable(upstream))
+    {
+    }
+    bump_memory_resource(const bump_memory_resource & ) = delete;
+    bump_memory_resource &operator=(const bump_memory_resource & ) = delete;
+
+    arena_type &arena() const noexcept { return *a_; }
+    std::pmr::memory_resource *upstream_resource() const noexcept
+    {
+        return upstream_;
+    }
+};
+//////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+#endif // header guard
@@ -0,0 +1,256 @@
+#ifndef __SMALL_AUTOGROW_ARRAY_H
+#define __SMALL_AUTOGROW_ARRAY_H
+
+#include"autogrow_array.h"
+#include<iterator>
+#include<cstring>
+
+namespace realloc4cpp {
+
+//////////////////////////////////////////////////////////////////////////////
+// Room for N elements of T inside the owner
+template<class T, std::size_t N>
+struct small_buffer_storage
+{
+    static_assert(N > 0, "No inline capacity");
+    alignas(T) unsigned char bytes[N * sizeof(T)];
+    bool used = false;
+
+    T *block() { return reinterpret_cast<T*>(bytes); }
+};
+//////////////////////////////////////////////////////////////////////////////
+// Serves the first allocation of at most N elements from the storage,
+// the rest comes from Fallback. A block spilled to Fallback starts at its
+// min_resizable_size(), so the blocks are always resized in place when
+// Fallback can do it. The inline block is never resized: the container
+// relocates once to Fallback.
+// Copies refer to the same storage; the rebound allocators have none.
+template<class T, std::size_t N, class Fallback = std::allocator<T>>
+class small_buffer_reallocator
+{
+    using FA = allocator_traits<Fallback>;
+public:
+    using value_type = T;
+    using size_type = typename FA::size_type;
+    using storage_type = small_buffer_storage<T, N>;
+private:
+    storage_type *s_;
+    Fallback fallback_;
+
+    template<class, std::size_t, class>
+    friend class small_buffer_reallocator;
+
+    bool is_inline(const T *p) const { return s_ && p == s_->block(); }
+    bool inline_free() const { return s_ && !s_->used; }
+    T *take_inline(size_type &n)
+    {
+        s_->used = true;
+        n = N;
+        return s_->block();
+    }
+public:
+    // the storage always goes together with its owner
+    using propagate_on_container_copy_assignment = std::false_type;
+    using propagate_on_container_move_assignment = std::false_type;
+    using propagate_on_container_swap = std::false_type;
+    using is_always_equal = std::false_type;
+    template<class U> struct rebind
+    {
+        using other = small_buffer_reallocator<U, N,
+            typename FA::template rebind_alloc<U>>;
+    };
+
+    explicit small_buffer_reallocator(storage_type &s,
+        const Fallback &f = Fallback())
+        : s_(&s), fallback_(f) {}
+    template<class U, class F2>
+    small_buffer_reallocator(
+        const small_buffer_reallocator<U,N,F2> &o) noexcept
+        : s_(nullptr), fallback_(o.fallback_) {}
+
+    [[nodiscard]] T *allocate(size_type n)
+    {
+        if(n <= N && inline_free()) return take_inline(n);
+        return FA::allocate(fallback_, n);
+    }
+    [[nodiscard]] T *allocate_at_least(size_type &n)
+    {
+        if(n <= N && inline_free()) return take_inline(n);
+        n = std::max(n, FA::min_resizable_size(fallback_));
+        return FA::allocate_at_least(fallback_, n);
+    }
+    void deallocate(T *p, size_type n)
+    {
+        if(is_inline(p)) s_->used = false;
+        else FA::deallocate(fallback_, p, n);
+    }
+    size_type good_size(size_type n) const
+    {
+        if(n <= N && s_) return N;
+        return FA::good_size(fallback_, n);
+    }
+    size_type min_resizable_size() const
+    {
+        return FA::min_resizable_size(fallback_);
+    }
+    [[nodiscard]] bool expand_by(T *p,
+        size_type &size, size_type preferred_n, size_type least_n)
+    {
+        if(is_inline(p)) return false;
+        return FA::expand_by(fallback_, p, size, preferred_n, least_n);
+    }
+    [[nodiscard]] bool shrink_by(T *p, size_type &size, size_type n)
+    {
+        if(is_inline(p)) return false;
+        return FA::shrink_by(fallback_, p, size, n);
+    }
+    // Moves the block between the storage and Fallback when required,
+    // the first used elements are kept
+    [[nodiscard]] T *reallocate(T *p,
+        size_type &size, size_type n, size_type used)
+    {
+        const bool to_inline = n <= N && inline_free();
+        if(!is_inline(p) && !to_inline)
+            return FA::reallocate(fallback_, p, size, n, used);
+        size_type new_size = n;
+        T *new_p = to_inline ? take_inline(new_size) :
+            allocate_at_least(new_size);
+        std::memcpy(static_cast<void*>(new_p), static_cast<const void*>(p),
+            std::min(used, n) * sizeof(T));
+        deallocate(p, size);
+        size = new_size;
+        return new_p;
+    }
+
+    const Fallback &fallback() const noexcept { return fallback_; }
+
+    template<class U, class F2>
+    bool operator==(const small_buffer_reallocator<U,N,F2> &o) const
+    {
+        return static_cast<const void*>(s_) ==
+            static_cast<const void*>(o.s_) && fallback_ == o.fallback_;
+    }
+    template<class U, class F2>
+    bool operator!=(const small_buffer_reallocator<U,N,F2> &o) const
+    {
+        return !(*this == o);
+    }
+};
+//////////////////////////////////////////////////////////////////////////////
+// autogrow_array keeping up to N elements inside: no allocation while
+// small. Above N it relocates once to a block of at least
+// min_resizable_size() of Allocator (16KiB for reallocator) and grows in
+// place from then on.
+// The move from a small array moves the elements, from a spilled one
+// takes the block if the allocators are equal.
+template<class T, std::size_t N, class Allocator = std::allocator<T>,
+    class Growth = doubling_growth, class Stats = default_realloc_stats>
+class small_autogrow_array
+:
+    private small_buffer_storage<T, N>, // initialised before the base
+    private autogrow_array<T, small_buffer_reallocator<T, N, Allocator>,
+        Growth, serial_relocation, Stats>
+{
+    using storage = small_buffer_storage<T, N>;
+    using inline_allocator = small_buffer_reallocator<T, N, Allocator>;
+    using base = autogrow_array<T, inline_allocator, Growth,
+        serial_relocation, Stats>;
+
+    storage &inline_storage() { return *this; }
+    void take(small_autogrow_array &o);
+public:
+    using typename base::value_type;
+    using allocator_type = Allocator;
+    using typename base::size_type;
+    using typename base::difference_type;
+    using typename base::reference;
+    using typename base::const_reference;
+    using typename base::pointer;
+    using typename base::const_pointer;
+    using typename base::iterator;
+    using typename base::const_iterator;
+    using typename base::reverse_iterator;
+    using typename base::const_reverse_iterator;
+    static constexpr size_type inline_capacity = N;
+
+    small_autogrow_array() : small_autogrow_array(Allocator()) {}
+    explicit small_autogrow_array(const Allocator &a)
+        : base(inline_allocator(inline_storage(), a)) {}
+    small_autogrow_array(const small_autogrow_array & ) = delete;
+    small_autogrow_array(small_autogrow_array &&o)
+    :
+        small_autogrow_array(o.get_allocator())
+    {
+        take(o);
+    }
+    small_autogrow_array &operator=(const small_autogrow_array & ) = delete;
+    small_autogrow_array &operator=(small_autogrow_array &&o)
+    {
+        if(this != &o) take(o);
+        return *this;
+    }
+
+    allocator_type get_allocator() const
+    {
+        return base::get_allocator().fallback();
+    }
+    using base::growth_policy;
+    // The elements are inside the object
+    bool is_inline() const
+    {
+        return base::data() == reinterpret_cast<const T*>(storage::bytes);
+    }
+
+    using base::empty;
+    using base::size;
+    using base::max_size;
+    using base::capacity;
+    using base::reserve;
+    using base::shrink_to_fit;
+    using base::trim;
+
+    using base::data;
+    using base::operator[];
+    using base::at;
+    using base::front;
+    using base::back;
+
+    using base::begin;
+    using base::end;
+    using base::cbegin;
+    using base::cend;
+    using base::rbegin;
+    using base::rend;
+
+    using base::push_back;
+    using base::emplace_back;
+    using base::pop_back;
+    using base::clear;
+    using base::emplace;
+    using base::insert;
+    using base::erase;
+    using base::append;
+    using base::append_n;
+    using base::resize;
+};
+//////////////////////////////////////////////////////////////////////////////
+//----------------------------------------------------------------------------
+template<class T, std::size_t N, class A, class G, class S>
+void small_autogrow_array<T,N,A,G,S>::take(small_autogrow_array &o)
+{
+    clear();
+    if(!o.is_inline() && o.capacity() && get_allocator() == o.get_allocator())
+    {
+        trim(); // frees the inline block as well
+        base::swap_buffers(o); // Fallback frees the blocks of each other
+        return;
+    }
+    append(std::make_move_iterator(o.begin()),
+        std::make_move_iterator(o.end()));
+    o.clear();
+}
+//----------------------------------------------------------------------------
+
+} // namespace
+
+#endif // header guard
@@ -0,0 +1,112 @@
+#ifndef __TCMALLOC_REALLOCATOR_H
+#define __TCMALLOC_REALLOCATOR_H
+
+#include"allocator_traits.h"
+#include<new>
+#include<cstring>
+#include<algorithm>
+#include<cstddef>
+#include<type_traits>
+#include<gperftools/tcmalloc.h>
+
+namespace realloc4cpp {
+
+//////////////////////////////////////////////////////////////////////////////
+// reallocator for tcmalloc (gperftools 2.6+). tcmalloc has no in-place
+// resizing: expand_by() succeeds only within the size class or span of
+// the block (tc_malloc_size()), good_size() is tc_nallocx().
+// Not over-aligned blocks are freed with sized deallocation.
+// Alignment is the minimum one, T can need more (see block_alignment()).
+template<class T, std::size_t Alignment = alignof(T)>
+struct tcmalloc_reallocator
+{
+    using value_type = T;
+    using size_type = std::size_t;
+    using is_always_equal = std::true_type;
+    template<class U> struct rebind
+        { using other = tcmalloc_reallocator<U, Alignment>; };
+
+    static_assert((Alignment & (Alignment - 1)) == 0,
+        "Alignment must be a power of 2");
+
+    tcmalloc_reallocator() = default;
+    template<class U>
+    constexpr tcmalloc_reallocator(
+        const tcmalloc_reallocator<U,Alignment> &) noexcept {}
+
+    [[nodiscard]] T *allocate(size_type n)
+    {
+        void *p = over_aligned ? ::tc_memalign(align, n * sizeof(T)) :
+            ::tc_malloc(n * sizeof(T));
+        if(!p) throw std::bad_alloc();
+        return static_cast<T*>(p);
+    }
+    [[nodiscard]] T *allocate_at_least(size_type &n)
+    {
+        T *p = allocate(n);
+        n = ::tc_malloc_size(p) / sizeof(T);
+        return p;
+    }
+    void deallocate(T *p, size_type n)
+    {
+        if constexpr(over_aligned) ::tc_free(p);
+        else ::tc_free_sized(p, n * sizeof(T));
+    }
+    size_type good_size(size_type n) const
+    {
+        return n ? ::tc_nallocx(n * sizeof(T), flags) / sizeof(T) : 0;
+    }
+    [[nodiscard]] bool expand_by(T *p,
+        size_type &size, size_type , size_type least_n)
+    {
+        const size_type usable = ::tc_malloc_size(p) / sizeof(T);
+        if(usable < size + least_n) return false;
+        size = usable;
+        return true;
+    }
+    // The first used elements are kept
+    [[nodiscard]] T *reallocate(T *p,
+        size_type &size, size_type n, size_type used)
+    {
+        n = std::max(n, size_type(1)); // tc_realloc(p, 0) frees p
+        if constexpr(over_aligned) // tc_realloc() drops the alignment
+        {
+            T *new_p = allocate_at_least(n);
+            std::memcpy(static_cast<void*>(new_p),
+                static_cast<const void*>(p), std::min(used, n) * sizeof(T));
+            deallocate(p, size);
+            size = n;
+            return new_p;
+        }
+        else
+        {
+            void *new_p = ::tc_realloc(p, n * sizeof(T));
+            if(!new_p) throw std::bad_alloc();
+            size = ::tc_malloc_size(new_p) / sizeof(T);
+            return static_cast<T*>(new_p);
+        }
+    }
+    static constexpr std::size_t alignment() { return align; }
+private:
+    static constexpr std::size_t align = block_alignment<T>(Alignment);
+    static constexpr bool over_aligned = align > alignof(std::max_align_t);
+    // MALLOCX_LG_ALIGN() of tc_nallocx()
+    static constexpr int flags = over_aligned ? __builtin_ctzll(align) : 0;
+};
+//////////////////////////////////////////////////////////////////////////////
+// Only the allocators with the same Alignment convert to each other: both
+// use sized deallocation or neither
+template<class U, class V, std::size_t A>
+inline bool operator==(tcmalloc_reallocator<U,A>, tcmalloc_reallocator<V,A>)
+{
+    return true;
+}
+template<class U, class V, std::size_t A>
+inline bool operator!=(tcmalloc_reallocator<U,A>, tcmalloc_reallocator<V,A>)
+{
+    return false;
+}
+
+} // namespace
+
+#endif // header guard
@@ -0,0 +1,580 @@
+#include"autogrow_array.h"
+#include"autogrow_deque.h"
+#include"autogrow_string.h"
+#include"incremental_array.h"
+#include"reallocator.h"
+#include<vector>
+#include<string>
+#include<set>
+#include<random>
+#include<iterator>
+#include<iostream>
+#include<cstdlib>
+
+//////////////////////////////////////////////////////////////////////////////
+// Randomized differential test: runs the same operation sequences on
+// autogrow_array, autogrow_deque and incremental_array and on
+// std::vector<int>, on autogrow_string and on std::string, and compares
+// them after each step. The elements count their constructions,
+// destructions and moves, check that they are alive when used and throw
+// on the Nth move or copy.
+//
+// Usage: differential [seeds]
+//
+// Build with the sanitizers and jemalloc junk filling (--enable-fill):
+//   g++ -std=c++17 -O1 -g -fsanitize=address,undefined
+//       -fno-omit-frame-pointer -I. tests/differential.cpp
+//       -ljemalloc -o differential
+// ASan does not see inside jemalloc: junk:true fills the freed and the new
+// blocks, so a use of the dead elements shows up as a bad magic.
+//////////////////////////////////////////////////////////////////////////////
+
+const char *je_malloc_conf = "junk:true";
+
+namespace {
+
+//////////////////////////////////////////////////////////////////////////////
+// Both element types fail the checks below instead of asserting
+[[noreturn]] void fail(const char *what, unsigned seed, int step)
+{
+    std::cerr << "FAILED: " << what << " (seed " << seed <<
+        ", step " << step << ")\n";
+    std::abort();
+}
+//----------------------------------------------------------------------------
+// Shared counters of the instrumented types
+struct instrumentation
+{
+    static inline long live = 0;
+    static inline long moves = 0, copies = 0;
+    static inline long throw_at = -1; // move/copy number that throws
+
+    struct injected {}; // the exception thrown
+
+    static void count(long &c)
+    {
+        if(throw_at >= 0 && moves + copies == throw_at)
+        {
+            throw_at = -1;
+            throw injected();
+        }
+        c++;
+    }
+    static void reset() { moves = copies = 0; throw_at = -1; }
+};
+//////////////////////////////////////////////////////////////////////////////
+// Knows the address of every live object: relocated by the ctors only
+class tracked : public instrumentation
+{
+    static constexpr unsigned alive = 0xA11CE, dead = 0xDEAD;
+    static inline std::set<const tracked *> objects;
+
+    int v;
+    unsigned magic;
+
+    void check() const
+    {
+        if(magic != alive || !objects.count(this))
+            fail("tracked: dead object used", 0, 0);
+    }
+    void born()
+    {
+        magic = alive;
+        objects.insert(this);
+        live++;
+    }
+public:
+    tracked(int v = 0) : v(v) { born(); }
+    tracked(const tracked &o) : v(o.v) { o.check(); count(copies); born(); }
+    tracked(tracked &&o) noexcept(false) : v(o.v)
+    {
+        o.check();
+        count(moves);
+        o.v = -1;
+        born();
+    }
+    tracked &operator=(const tracked &o)
+    {
+        check(); o.check();
+        v = o.v;
+        return *this;
+    }
+    tracked &operator=(tracked &&o)
+    {
+        check(); o.check();
+        v = o.v;
+        o.v = -1;
+        return *this;
+    }
+    ~tracked()
+    {
+        check();
+        objects.erase(this);
+        magic = dead;
+        live--;
+    }
+
+    int value() const { check(); return v; }
+    static std::size_t registered() { return objects.size(); }
+};
+//////////////////////////////////////////////////////////////////////////////
+// Relocated with memcpy() by the containers: only counts the objects
+class relocatable : public instrumentation
+{
+    static constexpr unsigned alive = 0x5AFE, dead = 0xDEAD;
+
+    int v;
+    unsigned magic;
+
+    void check() const
+    {
+        if(magic != alive) fail("relocatable: dead object used", 0, 0);
+    }
+public:
+    relocatable(int v = 0) : v(v), magic(alive) { live++; }
+    relocatable(const relocatable &o) : v(o.v), magic(alive)
+    {
+        o.check();
+        count(copies);
+        live++;
+    }
+    relocatable(relocatable &&o) noexcept(false) : v(o.v), magic(alive)
+    {
+        o.check();
+        count(moves);
+        o.v = -1;
+        live++;
+    }
+    relocatable &operator=(const relocatable &o)
+    {
+        check(); o.check();
+        v = o.v;
+        return *this;
+    }
+    relocatable &operator=(relocatable &&o)
+    {
+        check(); o.check();
+        v = o.v;
+        o.v = -1;
+        return *this;
+    }
+    ~relocatable() { check(); magic = dead; live--; }
+
+    int value() const { check(); return v; }
+    static std::size_t registered() { return live; }
+};
+//////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+template<>
+struct realloc4cpp::is_trivially_relocatable<relocatable> : std::true_type {};
+
+namespace {
+
+//////////////////////////////////////////////////////////////////////////////
+class checker
+{
+    unsigned seed;
+    int step = 0;
+public:
+    explicit checker(unsigned seed) : seed(seed) {}
+    void next_step() { step++; }
+    void operator()(bool ok, const char *what) const
+    {
+        if(!ok) fail(what, seed, step);
+    }
+    template<class Container>
+    void equal(const Container &a, const std::vector<int> &v) const
+    {
+        using T = typename Container::value_type;
+        (*this)(a.size() == v.size(), "size differs");
+        for(std::size_t i = 0; i < v.size(); i++)
+            (*this)(a[i].value() == v[i], "element differs");
+        (*this)(T::live == long(a.size()),
+            "constructions and destructions do not match");
+        (*this)(T::registered() == a.size(),
+            "live objects are not the elements");
+    }
+};
+//----------------------------------------------------------------------------
+// Operation sequences compared with std::vector step by step
+template<class T, class Allocator>
+void run_sequence(unsigned seed, int steps)
+{
+    using array = realloc4cpp::autogrow_array<T, Allocator>;
+    std::mt19937 rng(seed);
+    checker check(seed);
+    const auto random = [&rng](std::size_t n) { return rng() % n; };
+    {
+        array a;
+        std::vector<int> v;
+        for(int i = 0; i < steps; i++, check.next_step())
+        {
+            const std::size_t pos = random(v.size() + 1);
+            const int x = int(random(1000));
+            switch(random(16))
+            {
+                case 0: case 1:
+                    a.push_back(T(x)); v.push_back(x);
+                    break;
+                case 2:
+                    a.emplace_back(x); v.push_back(x);
+                    break;
+                case 3:
+                    a.insert(a.begin() + pos, T(x));
+                    v.insert(v.begin() + pos, x);
+                    break;
+                case 4:
+                {
+                    const std::size_t n = random(5);
+                    a.insert(a.begin() + pos, n, T(x));
+                    v.insert(v.begin() + pos, n, x);
+                    break;
+                }
+                case 5:
+                {
+                    const std::vector<T> src(random(8), T(x));
+                    a.insert(a.begin() + pos, src.begin(), src.end());
+                    v.insert(v.begin() + pos, src.size(), x);
+                    break;
+                }
+                case 6:
+                    if(pos == v.size()) break;
+                    a.erase(a.begin() + pos);
+                    v.erase(v.begin() + pos);
+                    break;
+                case 7:
+                {
+                    const std::size_t n = random(v.size() - pos + 1);
+                    a.erase(a.begin() + pos, a.begin() + pos + n);
+                    v.erase(v.begin() + pos, v.begin() + pos + n);
+                    break;
+                }
+                case 8:
+                    if(v.empty()) break;
+                    a.pop_back(); v.pop_back();
+                    break;
+                case 9:
+                {
+                    const std::size_t n = random(v.size() * 2 + 10);
+                    a.resize(n); v.resize(n, 0);
+                    break;
+                }
+                case 10:
+                {
+                    const std::size_t n = random(v.size() * 2 + 10);
+                    a.resize(n, T(x)); v.resize(n, x);
+                    break;
+                }
+                case 11:
+                    a.reserve(random(v.size() * 2 + 10));
+                    break;
+                case 12:
+                    a.shrink_to_fit();
+                    break;
+                case 13:
+                    a.trim(random(2) ? 0 : 4096);
+                    break;
+                case 14:
+                {
+                    array b(std::move(a));
+                    check(a.empty(), "moved-from array is not empty");
+                    a = std::move(b);
+                    break;
+                }
+                case 15:
+                    if(random(8)) a.append_n(random(4), T(x));
+                    else { a.clear(); v.clear(); }
+                    v.resize(a.size(), x);
+                    break;
+            }
+            check.equal(a, v);
+            check(a.size() <= a.capacity(), "size above capacity");
+        }
+    }
+    check(T::live == 0, "elements leaked or destroyed twice");
+    instrumentation::reset();
+}
+//----------------------------------------------------------------------------
+// Growth with the Nth move/copy throwing: push_back() has the strong
+// guarantee, insert() leaves valid elements only
+template<class T, class Allocator>
+void run_throwing(unsigned seed, int rounds)
+{
+    using array = realloc4cpp::autogrow_array<T, Allocator>;
+    std::mt19937 rng(seed);
+    checker check(seed);
+    for(int r = 0; r < rounds; r++, check.next_step())
+    {
+        {
+            array a;
+            std::vector<int> v;
+            for(int i = int(rng() % 64); i; i--)
+            {
+                a.emplace_back(i);
+                v.push_back(i);
+            }
+            instrumentation::reset();
+            instrumentation::throw_at = long(rng() % 128);
+            try
+            {
+                for(int i = 0; i < 64; i++)
+                {
+                    if(rng() % 4)
+                    {
+                        a.push_back(T(i));
+                        v.push_back(i);
+                        continue;
+                    }
+                    const std::size_t pos = rng() % (v.size() + 1);
+                    try
+                    {
+                        a.insert(a.begin() + pos, T(i));
+                        v.insert(v.begin() + pos, i);
+                    }
+                    catch(const instrumentation::injected & )
+                    {
+                        // Basic guarantee: any valid elements
+                        v.clear();
+                        for(const T &e : a) v.push_back(e.value());
+                        throw;
+                    }
+                }
+            }
+            catch(const instrumentation::injected & ) {}
+            instrumentation::reset();
+            check.equal(a, v);
+        }
+        check(T::live == 0, "elements leaked or destroyed twice");
+    }
+}
+//----------------------------------------------------------------------------
+// What only some of the append-only containers have
+template<class T, class A, std::size_t M>
+void check_more(const realloc4cpp::autogrow_deque<T,A,M> &a,
+    const std::vector<int> &v, const checker &check)
+{
+    std::size_t i = 0;
+    for(const T &e : a)
+        check(i < v.size() && e.value() == v[i++], "iteration differs");
+    check(i == v.size(), "iteration ends early");
+    i = 0;
+    a.for_each_chunk([&](const T *first, const T *last) {
+        check(first != last, "empty chunk");
+        for(; first != last; ++first)
+            check(i < v.size() && first->value() == v[i++], "chunk differs");
+    });
+    check(i == v.size(), "chunks end early");
+    check(a.empty() || a.front().value() == v.front(), "front differs");
+}
+template<class T, class A, std::size_t S>
+void check_more(const realloc4cpp::incremental_array<T,A,S> &a,
+    const std::vector<int> & , const checker &check)
+{
+    check(a.size() <= a.capacity(), "size above capacity");
+}
+template<class T, class A, std::size_t M>
+void settle(realloc4cpp::autogrow_deque<T,A,M> & ) {} // never relocates
+template<class T, class A, std::size_t S>
+void settle(realloc4cpp::incremental_array<T,A,S> &a)
+{
+    a.finish_relocation();
+}
+//----------------------------------------------------------------------------
+// autogrow_deque and incremental_array: appends and pops only.
+// A throwing push_back() leaves the container as it was.
+template<class Container>
+void run_appends(unsigned seed, int steps)
+{
+    using T = typename Container::value_type;
+    std::mt19937 rng(seed);
+    checker check(seed);
+    const auto random = [&rng](std::size_t n) { return rng() % n; };
+    {
+        Container a;
+        std::vector<int> v;
+        for(int i = 0; i < steps; i++, check.next_step())
+        {
+            const int x = int(random(1000));
+            switch(random(16))
+            {
+                default:
+                    a.push_back(T(x)); v.push_back(x);
+                    break;
+                case 8: case 9:
+                    a.emplace_back(x); v.push_back(x);
+                    break;
+                case 10:
+                {
+                    const T e(x);
+                    instrumentation::throw_at =
+                        T::moves + T::copies + long(random(4));
+                    try
+                    {
+                        a.push_back(e);
+                        v.push_back(x);
+                    }
+                    catch(const instrumentation::injected & ) {}
+                    instrumentation::reset();
+                    break;
+                }
+                case 11:
+                {
+                    // The source is an element, often one of the first
+                    // that a relocation moves
+                    if(v.empty()) break;
+                    const std::size_t pos =
+                        random((v.size() >> random(12)) + 1) % v.size();
+                    a.push_back(a[pos]); v.push_back(v[pos]);
+                    break;
+                }
+                case 12: case 13:
+                    if(v.empty()) break;
+                    a.pop_back(); v.pop_back();
+                    break;
+                case 14:
+                    if(random(16)) break;
+                    for(std::size_t n = random(64); n && !v.empty(); n--)
+                    {
+                        a.pop_back(); v.pop_back();
+                    }
+                    break;
+                case 15:
+                    settle(a);
+                    break;
+            }
+            if(i == steps - steps / 8) { a.clear(); v.clear(); }
+            // The full comparison is linear
+            check(a.size() == v.size(), "size differs");
+            check(T::live == long(a.size()),
+                "constructions and destructions do not match");
+            check(a.empty() || a.back().value() == v.back(), "back differs");
+            if(i % 32) continue;
+            check.equal(a, v);
+            check_more(a, v, check);
+        }
+        check.equal(a, v);
+        check_more(a, v, check);
+    }
+    check(T::live == 0, "elements leaked or destroyed twice");
+    instrumentation::reset();
+}
+//----------------------------------------------------------------------------
+// autogrow_string compared with std::string, including the appends and
+// the assignments of its own parts
+template<class Allocator>
+void run_string(const char *name, unsigned seed, int steps)
+{
+    using string = realloc4cpp::autogrow_string<char,
+        std::char_traits<char>, Allocator>;
+    using view = std::string_view;
+    std::mt19937 rng(seed);
+    checker check(seed);
+    const auto random = [&rng](std::size_t n) { return rng() % n; };
+    string a;
+    std::string s;
+    for(int i = 0; i < steps; i++, check.next_step())
+    {
+        const char ch = char('a' + random(26));
+        const std::size_t pos = random(s.size() + 1);
+        const std::size_t n = random(s.size() - pos + 1);
+        switch(random(12))
+        {
+            case 0: case 1:
+                a.push_back(ch); s.push_back(ch);
+                break;
+            case 2:
+            {
+                const std::size_t count = random(40);
+                a.append(count, ch); s.append(count, ch);
+                break;
+            }
+            case 3:
+            {
+                const std::string src(random(64), ch);
+                a += src.c_str(); s += src;
+                break;
+            }
+            case 4: // can be moved by the growth
+                a.append(a.data() + pos, n); s.append(s, pos, n);
+                break;
+            case 5:
+                if(s.empty()) break;
+                a.pop_back(); s.pop_back();
+                break;
+            case 6:
+            {
+                const std::size_t count = random(s.size() * 2 + 20);
+                a.resize(count, ch); s.resize(count, ch);
+                break;
+            }
+            case 7:
+                a.reserve(random(s.size() * 2 + 40));
+                break;
+            case 8:
+                a.shrink_to_fit();
+                break;
+            case 9:
+                a.assign(view(a).substr(pos, n)); s = s.substr(pos, n);
+                break;
+            case 10:
+                if(random(2))
+                {
+                    string b(a);
+                    check(b == view(s), "copy differs");
+                    a = std::move(b);
+                    check(b.empty(), "moved-from string is not empty");
+                }
+                else
+                {
+                    string b;
+                    b = a;
+                    b.swap(a);
+                    check(b == a, "swapped copy differs");
+                }
+                break;
+            case 11:
+                if(random(4)) break;
+                a.clear(); s.clear();
+                break;
+        }
+        check(a == view(s), "string differs");
+        check(a.c_str()[a.size()] == '\0', "no terminator");
+        check(a.size() <= a.capacity(), "size above capacity");
+    }
+    std::cout << name << " seed " << seed << ": ok\n";
+}
+//----------------------------------------------------------------------------
+template<class T, class Allocator>
+void run_all(const char *name, unsigned seed)
+{
+    run_sequence<T, Allocator>(seed, 20000);
+    run_throwing<T, Allocator>(seed, 300);
+    run_appends<realloc4cpp::autogrow_deque<T, Allocator>>(seed, 20000);
+    run_appends<realloc4cpp::incremental_array<T, Allocator>>(seed, 20000);
+    std::cout << name << " seed " << seed << ": ok\n";
+}
+//////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    using realloc4cpp::reallocator;
+    const unsigned seeds = argc > 1 ? unsigned(std::atoi(argv[1])) : 8;
+    for(unsigned seed = 1; seed <= seeds; seed++)
+    {
+        run_all<tracked, std::allocator<tracked>>(
+            "tracked, std::allocator", seed);
+        run_all<tracked, reallocator<tracked>>(
+            "tracked, reallocator", seed);
+        run_all<relocatable, std::allocator<relocatable>>(
+            "relocatable, std::allocator", seed);
+        run_all<relocatable, reallocator<relocatable>>(
+            "relocatable, reallocator", seed);
+        run_string<std::allocator<char>>("string, std::allocator",
+            seed, 20000);
+        run_string<reallocator<char>>("string, reallocator", seed, 20000);
+    }
+}
@@ -0,0 +1,180 @@
+#ifndef __TRIM_REGISTRY_H
+#define __TRIM_REGISTRY_H
+
+#include<atomic>
+#include<thread>
+#include<vector>
+#include<system_error>
+#include<cerrno>
+#include<cstdio>
+#include<fcntl.h>
+#include<poll.h>
+#include<unistd.h>
+
+namespace realloc4cpp {
+
+//////////////////////////////////////////////////////////////////////////////
+// Containers registered for trimming under memory pressure. Trimming is
+// shrink_by() only (see autogrow_array::trim()): slack is given back
+// in place, elements are never relocated.
+//
+// Containers are not thread-safe, so every thread has its own registry
+// and trims its own containers. Anyone (another thread, a signal handler,
+// psi_monitor below) calls request_trim(), the owner thread calls
+// trim_if_requested() from its loop, or trim() right away.
+class trim_registry
+{
+    struct entry
+    {
+        void *obj;
+        std::size_t (*trim)(void * , std::size_t );
+        std::size_t min_slack_bytes;
+    };
+    std::vector<entry> entries;
+    unsigned long seen = 0; // last handled request
+
+    static std::atomic<unsigned long> &requests()
+    {
+        static std::atomic<unsigned long> n{0};
+        return n;
+    }
+    template<class> friend class trim_registration;
+    template<class C>
+    void add(C &c, std::size_t min_slack_bytes)
+    {
+        entries.push_back({&c, [](void *obj, std::size_t min_slack) {
+            return static_cast<C *>(obj)->trim(min_slack);
+        }, min_slack_bytes});
+    }
+    void remove(void *obj)
+    {
+        for(auto it = entries.begin(); it != entries.end(); ++it)
+            if(it->obj == obj)
+            {
+                *it = entries.back();
+                entries.pop_back();
+                return;
+            }
+    }
+public:
+    trim_registry() = default;
+    trim_registry(const trim_registry & ) = delete;
+    trim_registry &operator=(const trim_registry & ) = delete;
+
+    // Registry of the calling thread
+    static trim_registry &local()
+    {
+        thread_local trim_registry r;
+        return r;
+    }
+    // Asks all the threads to trim, async-signal-safe
+    static void request_trim() noexcept
+    {
+        requests().fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::size_t size() const { return entries.size(); }
+    // Trims every registered container, returns the bytes released
+    std::size_t trim()
+    {
+        seen = requests().load(std::memory_order_relaxed);
+        std::size_t released = 0;
+        for(auto &e : entries) released += e.trim(e.obj, e.min_slack_bytes);
+        return released;
+    }
+    // Cheap check to call often
+    std::size_t trim_if_requested()
+    {
+        if(requests().load(std::memory_order_relaxed) == seen) return 0;
+        return trim();
+    }
+};
+//////////////////////////////////////////////////////////////////////////////
+// Keeps the container registered in the registry of the calling thread
+// while alive. Container must have
+//   std::size_t trim(std::size_t min_slack_bytes);
+// Must be destroyed by the same thread.
+template<class Container>
+class trim_registration
+{
+    Container *c;
+    trim_registry *r;
+public:
+    explicit trim_registration(Container &c,
+        std::size_t min_slack_bytes = std::size_t(1) << 20,
+        trim_registry &r = trim_registry::local())
+    :
+        c(&c), r(&r)
+    {
+        r.add(c, min_slack_bytes);
+    }
+    trim_registration(const trim_registration & ) = delete;
+    trim_registration &operator=(const trim_registration & ) = delete;
+    ~trim_registration() { r->remove(c); }
+};
+//////////////////////////////////////////////////////////////////////////////
+// Calls trim_registry::request_trim() when Linux PSI reports memory
+// pressure: tasks stalled for stall_us microseconds within window_us
+// (unprivileged processes need a window that is a multiple of 2s).
+// Needs a kernel with CONFIG_PSI, throws std::system_error otherwise.
+class psi_monitor
+{
+    int fd;
+    std::atomic<bool> stop{false};
+    std::thread thread;
+
+    void run()
+    {
+        pollfd p{fd, POLLPRI, 0};
+        while(!stop.load(std::memory_order_relaxed))
+        {
+            const int n = ::poll(&p, 1, 500); // to check stop periodically
+            if(n < 0 && errno != EINTR) break;
+            if(n > 0)
+            {
+                if(p.revents & POLLERR) break; // the file has gone
+                if(p.revents & POLLPRI) trim_registry::request_trim();
+            }
+        }
+    }
+public:
+    explicit psi_monitor(unsigned stall_us = 200000,
+        unsigned window_us = 2000000)
+    {
+        fd = ::open("/proc/pressure/memory", O_RDWR | O_NONBLOCK | O_CLOEXEC);
+        if(fd < 0) throw std::system_error(errno, std::system_category(),
+            "open(/proc/pressure/memory)");
+        char trigger[64];
+        const int len = std::snprintf(trigger, sizeof trigger,
+            "some %u %u", stall_us, window_us);
+        if(::write(fd, trigger, len + 1) < 0)
+        {
+            const int err = errno;
+            ::close(fd);
+            throw std::system_error(err, std::system_category(),
+                "PSI trigger");
+        }
+        try
+        {
+            thread = std::thread([this] { run(); });
+        }
+        catch(...)
+        {
+            ::close(fd);
+            throw;
+        }
+    }
+    psi_monitor(const psi_monitor & ) = delete;
+    psi_monitor &operator=(const psi_monitor & ) = delete;
+    ~psi_monitor()
+    {
+        stop = true;
+        thread.join();
+        ::close(fd);
+    }
+};
+//////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+#endif // header guard
@@ -0,0 +1,187 @@
+#ifndef __VECTOR_H
+#define __VECTOR_H
+
+#include"autogrow_array.h"
+#include<initializer_list>
+#include<algorithm>
+#include<iterator>
+
+namespace realloc4cpp {
+
+//////////////////////////////////////////////////////////////////////////////
+// std::vector replacement, switch with
+//   template<class T, class A = std::allocator<T>>
+//   using vector = realloc4cpp::vector<T, A>;
+// The buffer is expanded/shrunk in place when the allocator supports it,
+// so iterators are invalidated only when the elements are relocated.
+// Copying and the allocator propagation follow std::vector.
+// No vector<bool> specialization.
+template<class T, class Allocator = std::allocator<T>>
+class vector : private autogrow_array<T, Allocator>
+{
+    using base = autogrow_array<T, Allocator>;
+    using traits = std::allocator_traits<Allocator>;
+public:
+    using typename base::value_type;
+    using typename base::allocator_type;
+    using typename base::size_type;
+    using typename base::difference_type;
+    using typename base::reference;
+    using typename base::const_reference;
+    using typename base::pointer;
+    using typename base::const_pointer;
+    using typename base::iterator;
+    using typename base::const_iterator;
+    using typename base::reverse_iterator;
+    using typename base::const_reverse_iterator;
+
+    vector() = default;
+    explicit vector(const Allocator &a) noexcept : base(a) {}
+    explicit vector(size_type n, const Allocator &a = Allocator())
+        : base(a) { base::resize(n); }
+    vector(size_type n, const T &value, const Allocator &a = Allocator())
+        : base(a) { base::append_n(n, value); }
+    template<class InputIt, class = typename
+        std::iterator_traits<InputIt>::iterator_category>
+    vector(InputIt first, InputIt last, const Allocator &a = Allocator())
+        : base(a) { base::append(first, last); }
+    vector(std::initializer_list<T> il, const Allocator &a = Allocator())
+        : base(a) { base::append(il.begin(), il.end()); }
+    vector(const vector &o)
+        : vector(o, traits::select_on_container_copy_construction(
+            o.get_allocator())) {}
+    vector(const vector &o, const Allocator &a)
+        : base(a) { base::append(o.begin(), o.end()); }
+    vector(vector && ) noexcept = default;
+    vector(vector && , const Allocator & );
+    ~vector() = default;
+
+    vector &operator=(const vector & );
+    vector &operator=(vector && ) = default;
+    vector &operator=(std::initializer_list<T> il)
+    {
+        assign(il);
+        return *this;
+    }
+
+    void assign(size_type n, const T &value)
+    {
+        const T v(value); // value can be an element
+        base::clear();
+        base::append_n(n, v);
+    }
+    template<class InputIt, class = typename
+        std::iterator_traits<InputIt>::iterator_category>
+    void assign(InputIt first, InputIt last)
+    {
+        base::clear();
+        base::append(first, last);
+    }
+    void assign(std::initializer_list<T> il) { assign(il.begin(), il.end()); }
+
+    using base::get_allocator;
+
+    using base::at;
+    using base::operator[];
+    using base::front;
+    using base::back;
+    using base::data;
+
+    using base::begin;
+    using base::end;
+    using base::cbegin;
+    using base::cend;
+    using base::rbegin;
+    using base::rend;
+    const_reverse_iterator crbegin() const { return rbegin(); }
+    const_reverse_iterator crend() const { return rend(); }
+
+    using base::empty;
+    using base::size;
+    using base::max_size;
+    using base::reserve;
+    using base::capacity;
+    using base::shrink_to_fit;
+
+    using base::clear;
+    using base::insert;
+    iterator insert(const_iterator pos, std::initializer_list<T> il)
+    {
+        return base::insert(pos, il.begin(), il.end());
+    }
+    using base::emplace;
+    using base::erase;
+    using base::push_back;
+    using base::emplace_back;
+    using base::pop_back;
+    using base::resize;
+
+    void swap(vector &o) noexcept { base::swap(o); }
+};
+//////////////////////////////////////////////////////////////////////////////
+//----------------------------------------------------------------------------
+template<class T, class A>
+vector<T,A>::vector(vector &&o, const A &a)
+:
+    base(a)
+{
+    if(traits::is_always_equal::value || a == o.get_allocator())
+        base::swap(o);
+    else // the buffer cannot change the owner
+        base::append(std::make_move_iterator(o.begin()),
+            std::make_move_iterator(o.end()));
+}
+//----------------------------------------------------------------------------
+template<class T, class A>
+vector<T,A> &vector<T,A>::operator=(const vector &o)
+{
+    if(this == &o) return *this;
+    if constexpr(traits::propagate_on_container_copy_assignment::value)
+    {
+        if(!traits::is_always_equal::value &&
+            get_allocator() != o.get_allocator())
+                base::replace_allocator(o.get_allocator());
+    }
+    assign(o.begin(), o.end());
+    return *this;
+}
+//----------------------------------------------------------------------------
+template<class T, class A>
+inline void swap(vector<T,A> &a, vector<T,A> &b) noexcept { a.swap(b); }
+//----------------------------------------------------------------------------
+template<class T, class A>
+inline bool operator==(const vector<T,A> &a, const vector<T,A> &b)
+{
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+}
+template<class T, class A>
+inline bool operator!=(const vector<T,A> &a, const vector<T,A> &b)
+{
+    return !(a == b);
+}
+template<class T, class A>
+inline bool operator<(const vector<T,A> &a, const vector<T,A> &b)
+{
+    return std::lexicographical_compare(a.begin(), a.end(),
+        b.begin(), b.end());
+}
+template<class T, class A>
+inline bool operator>(const vector<T,A> &a, const vector<T,A> &b)
+{
+    return b < a;
+}
+template<class T, class A>
+inline bool operator<=(const vector<T,A> &a, const vector<T,A> &b)
+{
+    return !(b < a);
+}
+template<class T, class A>
+inline bool operator>=(const vector<T,A> &a, const vector<T,A> &b)
+{
+    return !(a < b);
+}
+//----------------------------------------------------------------------------
+
+} // namespace
+
+#endif // header guard